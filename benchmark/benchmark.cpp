@@ -0,0 +1,173 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tensorflow_cpp/model.h>
+
+
+struct BenchmarkOptions {
+  std::string model_path;
+  std::vector<int> batch_sizes = {1};
+  std::vector<int> thread_counts = {1};
+  int iterations = 100;
+  int warmup_iterations = 10;
+};
+
+
+void printUsage(const std::string& name) {
+
+  std::cout << "Usage: " << name << " MODEL_PATH [options]" << std::endl
+            << std::endl
+            << "Options:" << std::endl
+            << "  --batch-sizes N[,N...]  batch sizes to run (default: 1)"
+            << std::endl
+            << "  --threads N[,N...]      concurrent callers (default: 1)"
+            << std::endl
+            << "  --iterations N          timed runs per thread (default: 100)"
+            << std::endl
+            << "  --warmup N              untimed runs per thread (default: 10)"
+            << std::endl;
+}
+
+
+std::vector<int> parseList(const std::string& arg) {
+
+  std::vector<int> values;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) values.push_back(std::stoi(item));
+
+  return values;
+}
+
+
+bool parseArgs(int argc, char** argv, BenchmarkOptions& options) {
+
+  if (argc < 2) return false;
+  options.model_path = argv[1];
+  for (int k = 2; k < argc; k++) {
+    const std::string arg = argv[k];
+    if (k + 1 >= argc) return false;
+    const std::string value = argv[++k];
+    if (arg == "--batch-sizes")
+      options.batch_sizes = parseList(value);
+    else if (arg == "--threads")
+      options.thread_counts = parseList(value);
+    else if (arg == "--iterations")
+      options.iterations = std::stoi(value);
+    else if (arg == "--warmup")
+      options.warmup_iterations = std::stoi(value);
+    else
+      return false;
+  }
+
+  return options.iterations > 0 && !options.batch_sizes.empty() &&
+         !options.thread_counts.empty();
+}
+
+
+double percentile(const std::vector<double>& sorted_values, const double p) {
+
+  const int idx = std::min<int>(sorted_values.size() - 1,
+                                p / 100.0 * sorted_values.size());
+
+  return sorted_values[idx];
+}
+
+
+long peakMemoryKB() {
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss;
+}
+
+
+int main(int argc, char** argv) {
+
+  BenchmarkOptions options;
+  if (!parseArgs(argc, argv, options)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // load model
+  const auto load_start = std::chrono::steady_clock::now();
+  tensorflow_cpp::Model model(options.model_path);
+  const double load_time_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - load_start)
+                                .count();
+  std::cout << model.getInfoString() << std::endl;
+  std::cout << "Load time: " << std::fixed << std::setprecision(1)
+            << load_time_ms << " ms" << std::endl
+            << std::endl;
+
+  std::cout << std::setw(7) << "batch" << std::setw(9) << "threads"
+            << std::setw(11) << "p50 [ms]" << std::setw(11) << "p90 [ms]"
+            << std::setw(11) << "p99 [ms]" << std::setw(15) << "samples/s"
+            << std::setw(16) << "peak RSS [MB]" << std::endl;
+
+  for (const int batch_size : options.batch_sizes) {
+
+    const std::vector<tensorflow::Tensor> inputs =
+      model.makeDummyInputs(batch_size);
+
+    for (const int n_threads : options.thread_counts) {
+
+      // run model concurrently, recording per-call latencies
+      using Clock = std::chrono::steady_clock;
+      std::vector<std::vector<double>> latencies(n_threads);
+      std::vector<Clock::time_point> starts(n_threads), ends(n_threads);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+          std::vector<tensorflow::Tensor> outputs;
+          for (int k = 0; k < options.warmup_iterations; k++)
+            model.run(inputs, outputs);
+          latencies[t].reserve(options.iterations);
+          starts[t] = Clock::now();
+          for (int k = 0; k < options.iterations; k++) {
+            const auto call_start = Clock::now();
+            model.run(inputs, outputs);
+            latencies[t].push_back(std::chrono::duration<double, std::milli>(
+                                     Clock::now() - call_start)
+                                     .count());
+          }
+          ends[t] = Clock::now();
+        });
+      }
+      for (auto& thread : threads) thread.join();
+
+      // report latency percentiles, throughput and peak memory
+      std::vector<double> all_latencies;
+      for (const auto& l : latencies)
+        all_latencies.insert(all_latencies.end(), l.begin(), l.end());
+      std::sort(all_latencies.begin(), all_latencies.end());
+      const double timed_s =
+        std::chrono::duration<double>(
+          *std::max_element(ends.begin(), ends.end()) -
+          *std::min_element(starts.begin(), starts.end()))
+          .count();
+      const double throughput = double(n_threads) * options.iterations *
+                                batch_size / std::max(timed_s, 1e-9);
+      std::cout << std::setw(7) << batch_size << std::setw(9) << n_threads
+                << std::setprecision(3) << std::setw(11)
+                << percentile(all_latencies, 50) << std::setw(11)
+                << percentile(all_latencies, 90) << std::setw(11)
+                << percentile(all_latencies, 99) << std::setprecision(1)
+                << std::setw(15) << throughput << std::setw(16)
+                << peakMemoryKB() / 1024.0 << std::endl;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,500 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief BatchingModel class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor_util.h>
+#include <tensorflow_cpp/model.h>
+
+
+namespace tensorflow_cpp {
+
+
+/**
+ * @brief Wrapper class for dynamically batching requests from many threads.
+ *
+ * Requests are queued and concatenated along the batch dimension (dimension
+ * 0) of all inputs. A batch is run as soon as `max_batch_size` samples are
+ * queued or the oldest request has waited for `max_queue_delay_us`. The
+ * output slices are then passed back to each caller through a future.
+ *
+ * All model inputs must have a dynamic batch dimension. Requests are only
+ * batched together if their inputs match in all other dimensions.
+ */
+class BatchingModel {
+
+ public:
+  /**
+   * @brief Creates an uninitialized model.
+   */
+  BatchingModel() {}
+
+  /**
+   * @brief Creates a model by loading it from disk.
+   *
+   * @param[in]  model_path                       SavedModel or FrozenGraph path
+   * @param[in]  max_batch_size                   maximum number of samples per
+   * batch
+   * @param[in]  max_queue_delay_us               maximum time a request waits
+   * for a batch to fill up [us]
+   * @param[in]  warmup                           run dummy inference to warmup
+   * @param[in]  allow_growth                     dynamically grow GPU usage
+   * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+   * @param[in]  visible_device_list              list of GPUs to use, e.g.
+   * "0,1"
+   */
+  BatchingModel(const std::string& model_path, const int max_batch_size = 32,
+                const int max_queue_delay_us = 1000, const bool warmup = false,
+                const bool allow_growth = true,
+                const double per_process_gpu_memory_fraction = 0,
+                const std::string& visible_device_list = "") {
+
+    loadModel(model_path, max_batch_size, max_queue_delay_us, warmup,
+              allow_growth, per_process_gpu_memory_fraction,
+              visible_device_list);
+  }
+
+  /**
+   * @brief Processes all pending requests and stops the batching thread.
+   */
+  ~BatchingModel() {
+    stop();
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk and starts the
+   * batching thread.
+   *
+   * @param[in]  model_path                       SavedModel or FrozenGraph path
+   * @param[in]  max_batch_size                   maximum number of samples per
+   * batch
+   * @param[in]  max_queue_delay_us               maximum time a request waits
+   * for a batch to fill up [us]
+   * @param[in]  warmup                           run dummy inference to warmup
+   * @param[in]  allow_growth                     dynamically grow GPU usage
+   * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+   * @param[in]  visible_device_list              list of GPUs to use, e.g.
+   * "0,1"
+   */
+  void loadModel(const std::string& model_path, const int max_batch_size = 32,
+                 const int max_queue_delay_us = 1000, const bool warmup = false,
+                 const bool allow_growth = true,
+                 const double per_process_gpu_memory_fraction = 0,
+                 const std::string& visible_device_list = "") {
+
+    loadModel(model_path, max_batch_size, max_queue_delay_us,
+              makeSessionConfig(allow_growth, per_process_gpu_memory_fraction,
+                                visible_device_list),
+              warmup);
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk and starts the
+   * batching thread.
+   *
+   * @param[in]  model_path          SavedModel or FrozenGraph path
+   * @param[in]  max_batch_size      maximum number of samples per batch
+   * @param[in]  max_queue_delay_us  maximum time a request waits for a batch
+   * to fill up [us]
+   * @param[in]  config              session configuration
+   * @param[in]  warmup              run dummy inference to warmup
+   */
+  void loadModel(const std::string& model_path, const int max_batch_size,
+                 const int max_queue_delay_us, const SessionConfig& config,
+                 const bool warmup = false) {
+
+    stop();
+
+    model_.loadModel(model_path, config, warmup);
+
+    // batching requires a dynamic batch dimension on all inputs
+    const auto input_shapes = model_.getInputShapes();
+    for (int k = 0; k < input_shapes.size(); k++) {
+      if (!input_shapes[k].empty() && input_shapes[k][0] != -1) {
+        throw std::runtime_error(
+          "BatchingModel requires a dynamic batch dimension, but input '" +
+          model_.inputNames()[k] + "' has fixed batch size " +
+          std::to_string(input_shapes[k][0]));
+      }
+    }
+
+    max_batch_size_ = std::max(1, max_batch_size);
+    max_queue_delay_ = std::chrono::microseconds(max_queue_delay_us);
+
+    // start batching thread
+    stop_ = false;
+    thread_ = std::thread(&BatchingModel::processBatches, this);
+  }
+
+  /**
+   * @brief Checks whether the model is loaded already.
+   *
+   * @return  true   if model is loaded
+   * @return  false  if model is not loaded
+   */
+  bool isLoaded() const {
+    return model_.isLoaded() && thread_.joinable();
+  }
+
+  /**
+   * @brief Queues a request for batched inference.
+   *
+   * Input tensors are expected in the order given by `Model::inputNames` and
+   * may contain one or more samples along dimension 0. The future holds the
+   * corresponding slices of the output tensors, in the order given by
+   * `Model::outputNames`.
+   *
+   * @param[in]  input_tensors                     input tensors
+   *
+   * @return  std::future<std::vector<tf::Tensor>> output tensors
+   */
+  std::future<std::vector<tf::Tensor>> enqueue(
+    const std::vector<tf::Tensor>& input_tensors) {
+
+    if (input_tensors.size() != model_.nInputs()) {
+      throw std::runtime_error(
+        "Model has " + std::to_string(model_.nInputs()) + " inputs, but " +
+        std::to_string(input_tensors.size()) + " input tensors were given");
+    }
+    for (const auto& tensor : input_tensors) {
+      if (tensor.dims() < 1 || tensor.dim_size(0) < 1)
+        throw std::runtime_error(
+          "BatchingModel requires input tensors with a batch dimension");
+      if (tensor.dim_size(0) != input_tensors[0].dim_size(0))
+        throw std::runtime_error(
+          "Cannot split inputs with differing batch dimensions");
+    }
+
+    Request request;
+    request.inputs = input_tensors;
+    request.batch_size = input_tensors[0].dim_size(0);
+    request.enqueue_time = std::chrono::steady_clock::now();
+    std::future<std::vector<tf::Tensor>> future =
+      request.promise.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_ || !thread_.joinable())
+        throw std::runtime_error("Cannot queue request, model is not loaded");
+      queued_samples_ += request.batch_size;
+      queue_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+
+    return future;
+  }
+
+  /**
+   * @brief Runs the model as part of a batch and waits for the result.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<tf::Tensor>& input_tensors) {
+
+    return enqueue(input_tensors).get();
+  }
+
+  /**
+   * @brief Runs the model as part of a batch and waits for the result.
+   *
+   * This version of `operator()` is limited to single-input/single-output
+   * models.
+   *
+   * @param[in]  input_tensor  input tensor
+   *
+   * @return  tf::Tensor       output tensor
+   */
+  tf::Tensor operator()(const tf::Tensor& input_tensor) {
+
+    if (model_.nInputs() != 1 || model_.nOutputs() != 1) {
+      throw std::runtime_error(
+        "'tf::Tensor tensorflow_cpp::BatchingModel::operator()(const "
+        "tf::Tensor&)' is only available for single-input/single-output "
+        "models. Found " +
+        std::to_string(model_.nInputs()) + " inputs and " +
+        std::to_string(model_.nOutputs()) + " outputs.");
+    }
+
+    return enqueue({input_tensor}).get()[0];
+  }
+
+  /**
+   * @brief Returns the number of samples currently waiting in the queue.
+   *
+   * @return  int  number of queued samples
+   */
+  int queueSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_samples_;
+  }
+
+  /**
+   * @brief Returns the maximum number of samples per batch.
+   *
+   * @return  int  maximum batch size
+   */
+  int maxBatchSize() const {
+    return max_batch_size_;
+  }
+
+  /**
+   * @brief Returns the underlying model.
+   *
+   * @return  const Model&  model
+   */
+  const Model& model() const {
+    return model_;
+  }
+
+ protected:
+  /**
+   * @brief Queued inference request.
+   */
+  struct Request {
+
+    /**
+     * @brief input tensors
+     */
+    std::vector<tf::Tensor> inputs;
+
+    /**
+     * @brief number of samples along dimension 0
+     */
+    int batch_size = 0;
+
+    /**
+     * @brief time at which the request was queued
+     */
+    std::chrono::steady_clock::time_point enqueue_time;
+
+    /**
+     * @brief promise for output tensors
+     */
+    std::promise<std::vector<tf::Tensor>> promise;
+  };
+
+  /**
+   * @brief Stops the batching thread after processing all pending requests.
+   */
+  void stop() {
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  /**
+   * @brief Checks whether two requests can be concatenated into one batch.
+   *
+   * @param[in]  a      request
+   * @param[in]  b      request
+   *
+   * @return  true      if all inputs match except for dimension 0
+   * @return  false     otherwise
+   */
+  static bool isBatchable(const Request& a, const Request& b) {
+
+    for (int k = 0; k < a.inputs.size(); k++) {
+      const tf::Tensor& ta = a.inputs[k];
+      const tf::Tensor& tb = b.inputs[k];
+      if (ta.dtype() != tb.dtype() || ta.dims() != tb.dims()) return false;
+      for (int d = 1; d < ta.dims(); d++)
+        if (ta.dim_size(d) != tb.dim_size(d)) return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Collects, runs and scatters batches until stopped.
+   */
+  void processBatches() {
+
+    while (true) {
+
+      // wait for first request
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+
+      // wait until batch is full or oldest request has waited long enough
+      const auto deadline = queue_.front().enqueue_time + max_queue_delay_;
+      cv_.wait_until(lock, deadline, [this] {
+        return stop_ || queued_samples_ >= max_batch_size_;
+      });
+
+      // collect compatible requests
+      std::vector<Request> batch;
+      int batch_size = 0;
+      for (auto it = queue_.begin(); it != queue_.end();) {
+        if (!batch.empty() &&
+            (batch_size + it->batch_size > max_batch_size_ ||
+             !isBatchable(batch.front(), *it))) {
+          it++;
+          continue;
+        }
+        batch_size += it->batch_size;
+        batch.push_back(std::move(*it));
+        it = queue_.erase(it);
+        if (batch_size >= max_batch_size_) break;
+      }
+      queued_samples_ -= batch_size;
+      lock.unlock();
+
+      runBatch(batch, batch_size);
+    }
+  }
+
+  /**
+   * @brief Runs a batch of requests and fulfills their promises.
+   *
+   * @param[in,out]  batch       requests
+   * @param[in]      batch_size  total number of samples
+   */
+  void runBatch(std::vector<Request>& batch, const int batch_size) {
+
+    try {
+
+      // concatenate inputs along batch dimension
+      std::vector<tf::Tensor> inputs;
+      if (batch.size() == 1) {
+        inputs = batch[0].inputs;
+      } else {
+        for (int k = 0; k < model_.nInputs(); k++) {
+          std::vector<tf::Tensor> slices;
+          for (const auto& request : batch) slices.push_back(request.inputs[k]);
+          tf::Tensor input;
+          tf::Status status = tf::tensor::Concat(slices, &input);
+          if (!status.ok())
+            throw std::runtime_error("Failed to concatenate batch: " +
+                                     status.ToString());
+          inputs.push_back(input);
+        }
+      }
+
+      // run model
+      std::vector<tf::Tensor> outputs;
+      model_.run(inputs, outputs);
+      if (batch.size() == 1) {
+        batch[0].promise.set_value(std::move(outputs));
+        return;
+      }
+
+      // split outputs along batch dimension
+      std::vector<tf::int64> sizes;
+      for (const auto& request : batch) sizes.push_back(request.batch_size);
+      std::vector<std::vector<tf::Tensor>> request_outputs(batch.size());
+      for (const auto& output : outputs) {
+        if (output.dims() < 1 || output.dim_size(0) != batch_size)
+          throw std::runtime_error(
+            "Cannot split model output of shape " +
+            output.shape().DebugString() + " into batch of size " +
+            std::to_string(batch_size));
+        std::vector<tf::Tensor> slices;
+        tf::Status status = tf::tensor::Split(output, sizes, &slices);
+        if (!status.ok())
+          throw std::runtime_error("Failed to split batch: " +
+                                   status.ToString());
+        for (int r = 0; r < batch.size(); r++)
+          request_outputs[r].push_back(slices[r]);
+      }
+      for (int r = 0; r < batch.size(); r++)
+        batch[r].promise.set_value(std::move(request_outputs[r]));
+
+    } catch (...) {
+      for (auto& request : batch)
+        request.promise.set_exception(std::current_exception());
+    }
+  }
+
+ protected:
+  /**
+   * @brief underlying model
+   */
+  Model model_;
+
+  /**
+   * @brief maximum number of samples per batch
+   */
+  int max_batch_size_ = 32;
+
+  /**
+   * @brief maximum time a request waits for a batch to fill up
+   */
+  std::chrono::microseconds max_queue_delay_{1000};
+
+  /**
+   * @brief queued requests
+   */
+  std::deque<Request> queue_;
+
+  /**
+   * @brief number of samples in queued requests
+   */
+  int queued_samples_ = 0;
+
+  /**
+   * @brief whether the batching thread is requested to stop
+   */
+  bool stop_ = false;
+
+  /**
+   * @brief mutex guarding the queue
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * @brief condition variable signaling new requests
+   */
+  std::condition_variable cv_;
+
+  /**
+   * @brief batching thread
+   */
+  std::thread thread_;
+};
+
+
+}  // namespace tensorflow_cpp
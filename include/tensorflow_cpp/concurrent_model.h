@@ -0,0 +1,239 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ConcurrentModel class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tensorflow_cpp/model.h>
+
+
+namespace tensorflow_cpp {
+
+
+/**
+ * @brief Wrapper class for running a single model from multiple threads.
+ *
+ * The model is loaded once and shared by all threads. All threads run the
+ * model's precompiled default callable, which TensorFlow allows to run
+ * concurrently without any synchronization in the wrapper. The session's
+ * inter-op pool is sized to `n_workers`, so that every concurrent call can
+ * make progress. The intra-op pool is shared by all calls of the session, so
+ * it keeps TensorFlow's default size of one thread per core.
+ */
+class ConcurrentModel {
+
+ public:
+  /**
+   * @brief Creates an uninitialized model.
+   */
+  ConcurrentModel() {}
+
+  /**
+   * @brief Creates a model by loading it from disk.
+   *
+   * @param[in]  model_path                       SavedModel or FrozenGraph path
+   * @param[in]  n_workers                        number of concurrent callers
+   * (0: number of cores)
+   * @param[in]  warmup                           run dummy inference to warmup
+   * @param[in]  allow_growth                     dynamically grow GPU usage
+   * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+   * @param[in]  visible_device_list              list of GPUs to use, e.g.
+   * "0,1"
+   * @param[in]  intra_op_parallelism_threads     threads shared by all ops
+   * (0: TensorFlow default, number of cores)
+   * @param[in]  inter_op_parallelism_threads     threads across ops (0:
+   * `n_workers`)
+   */
+  ConcurrentModel(const std::string& model_path, const int n_workers = 0,
+                  const bool warmup = false, const bool allow_growth = true,
+                  const double per_process_gpu_memory_fraction = 0,
+                  const std::string& visible_device_list = "",
+                  const int intra_op_parallelism_threads = 0,
+                  const int inter_op_parallelism_threads = 0) {
+
+    loadModel(model_path, n_workers, warmup, allow_growth,
+              per_process_gpu_memory_fraction, visible_device_list,
+              intra_op_parallelism_threads, inter_op_parallelism_threads);
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk.
+   *
+   * @param[in]  model_path                       SavedModel or FrozenGraph path
+   * @param[in]  n_workers                        number of concurrent callers
+   * (0: number of cores)
+   * @param[in]  warmup                           run dummy inference to warmup
+   * @param[in]  allow_growth                     dynamically grow GPU usage
+   * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+   * @param[in]  visible_device_list              list of GPUs to use, e.g.
+   * "0,1"
+   * @param[in]  intra_op_parallelism_threads     threads shared by all ops
+   * (0: TensorFlow default, number of cores)
+   * @param[in]  inter_op_parallelism_threads     threads across ops (0:
+   * `n_workers`)
+   */
+  void loadModel(const std::string& model_path, const int n_workers = 0,
+                 const bool warmup = false, const bool allow_growth = true,
+                 const double per_process_gpu_memory_fraction = 0,
+                 const std::string& visible_device_list = "",
+                 const int intra_op_parallelism_threads = 0,
+                 const int inter_op_parallelism_threads = 0) {
+
+    loadModel(model_path, n_workers,
+              makeSessionConfig(allow_growth, per_process_gpu_memory_fraction,
+                                visible_device_list,
+                                intra_op_parallelism_threads,
+                                inter_op_parallelism_threads),
+              warmup);
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk.
+   *
+   * An unset (0) inter-op pool size in `config` is set to `n_workers`. The
+   * intra-op pool is shared by all concurrent calls and left as configured.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  n_workers   number of concurrent callers (0: number of cores)
+   * @param[in]  config      session configuration
+   * @param[in]  warmup      run dummy inference to warmup
+   */
+  void loadModel(const std::string& model_path, const int n_workers,
+                 const SessionConfig& config, const bool warmup = false) {
+
+    const int n_cores = std::max(1u, std::thread::hardware_concurrency());
+    n_workers_ = (n_workers > 0) ? n_workers : n_cores;
+    SessionConfig worker_config = config;
+    if (worker_config.inter_op_parallelism_threads <= 0)
+      worker_config.inter_op_parallelism_threads = n_workers_;
+
+    model_.loadModel(model_path, worker_config, warmup);
+  }
+
+  /**
+   * @brief Checks whether the model is loaded already.
+   *
+   * @return  true   if model is loaded
+   * @return  false  if model is not loaded
+   */
+  bool isLoaded() const {
+    return model_.isLoaded();
+  }
+
+  /**
+   * @brief Runs the model.
+   *
+   * Input tensors are expected in the order given by `Model::inputNames`,
+   * output tensors are returned in the order given by `Model::outputNames`.
+   * May be called concurrently from multiple threads.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    return model_(input_tensors);
+  }
+
+  /**
+   * @brief Runs the model.
+   *
+   * This version of `operator()` is limited to single-input/single-output
+   * models. May be called concurrently from multiple threads.
+   *
+   * @param[in]  input_tensor  input tensor
+   *
+   * @return  tf::Tensor       output tensor
+   */
+  tf::Tensor operator()(const tf::Tensor& input_tensor) const {
+
+    if (model_.nInputs() != 1 || model_.nOutputs() != 1) {
+      throw std::runtime_error(
+        "'tf::Tensor tensorflow_cpp::ConcurrentModel::operator()(const "
+        "tf::Tensor&)' is only available for single-input/single-output "
+        "models. Found " +
+        std::to_string(model_.nInputs()) + " inputs and " +
+        std::to_string(model_.nOutputs()) + " outputs.");
+    }
+
+    return model_(input_tensor);
+  }
+
+  /**
+   * @brief Runs the model, writing into a caller-provided output vector.
+   *
+   * See `Model::run`. May be called concurrently from multiple threads, as
+   * long as each thread uses its own output vector.
+   *
+   * @param[in]   input_tensors   input tensors
+   * @param[out]  output_tensors  output tensors
+   */
+  void run(const std::vector<tf::Tensor>& input_tensors,
+           std::vector<tf::Tensor>& output_tensors) const {
+
+    model_.run(input_tensors, output_tensors);
+  }
+
+  /**
+   * @brief Returns the underlying shared model.
+   *
+   * @return  const Model&  model
+   */
+  const Model& model() const {
+    return model_;
+  }
+
+  /**
+   * @brief Returns the number of workers the thread pools are sized for.
+   *
+   * @return  int  number of workers
+   */
+  int nWorkers() const {
+    return n_workers_;
+  }
+
+ protected:
+  /**
+   * @brief underlying shared model
+   */
+  Model model_;
+
+  /**
+   * @brief number of workers
+   */
+  int n_workers_ = 0;
+};
+
+
+}  // namespace tensorflow_cpp
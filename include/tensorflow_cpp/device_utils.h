@@ -0,0 +1,256 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utility functions for devices and memory placement
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tensorflow/core/common_runtime/device.h>
+#include <tensorflow/core/common_runtime/device_mgr.h>
+#include <tensorflow/core/framework/allocator.h>
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/public/session.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Determines the names of all devices available to a session.
+ *
+ * @param[in]  session                   session
+ *
+ * @return  std::vector<std::string>     list of full device names
+ */
+inline std::vector<std::string> getSessionDeviceNames(tf::Session* session) {
+
+  std::vector<tf::DeviceAttributes> devices;
+  tf::Status status = session->ListDevices(&devices);
+  if (!status.ok())
+    throw std::runtime_error("Failed to list devices: " + status.ToString());
+  std::vector<std::string> names;
+  for (const auto& device : devices) names.push_back(device.name());
+
+  return names;
+}
+
+
+/**
+ * @brief Determines the name of the n-th GPU available to a session.
+ *
+ * @param[in]  session       session
+ * @param[in]  gpu_index     index among the session's GPUs
+ *
+ * @return  std::string      full device name, empty if there is no such GPU
+ */
+inline std::string getSessionGpuDeviceName(tf::Session* session,
+                                           const int gpu_index = 0) {
+
+  std::vector<tf::DeviceAttributes> devices;
+  tf::Status status = session->ListDevices(&devices);
+  if (!status.ok())
+    throw std::runtime_error("Failed to list devices: " + status.ToString());
+  int k = 0;
+  for (const auto& device : devices) {
+    if (device.device_type() != "GPU") continue;
+    if (k++ == gpu_index) return device.name();
+  }
+
+  return "";
+}
+
+
+/**
+ * @brief Looks up a device of a session by name.
+ *
+ * @param[in]  session       session
+ * @param[in]  device_name   full or local device name, e.g. "/device:GPU:0"
+ *
+ * @return  tf::Device*      device
+ */
+inline tf::Device* getSessionDevice(tf::Session* session,
+                                    const std::string& device_name) {
+
+  const tf::DeviceMgr* device_mgr;
+  tf::Status status = session->LocalDeviceManager(&device_mgr);
+  if (!status.ok())
+    throw std::runtime_error("Failed to access session devices: " +
+                             status.ToString());
+  tf::Device* device;
+  status = device_mgr->LookupDevice(device_name, &device);
+  if (!status.ok())
+    throw std::runtime_error("Failed to find device '" + device_name +
+                             "': " + status.ToString());
+
+  return device;
+}
+
+
+/**
+ * @brief Returns an allocator for memory associated with a session device.
+ *
+ * With `pinned_host`, the allocator returns page-locked host memory that can
+ * be copied to/from the device without an intermediate staging copy.
+ * Otherwise, it returns memory on the device itself.
+ *
+ * @param[in]  session       session
+ * @param[in]  device_name   full or local device name, e.g. "/device:GPU:0"
+ * @param[in]  pinned_host   whether to allocate pinned host memory
+ *
+ * @return  tf::Allocator*   allocator
+ */
+inline tf::Allocator* getSessionDeviceAllocator(tf::Session* session,
+                                                const std::string& device_name,
+                                                const bool pinned_host = false) {
+
+  tf::Device* device = getSessionDevice(session, device_name);
+  tf::AllocatorAttributes attributes;
+  if (pinned_host) {
+    attributes.set_on_host(true);
+    attributes.set_gpu_compatible(true);
+  }
+
+  return device->GetAllocator(attributes);
+}
+
+
+/**
+ * @brief Memory statistics of a device allocator.
+ */
+struct MemoryStats {
+
+  /**
+   * @brief whether the allocator collects statistics (all other fields are
+   * zero otherwise)
+   */
+  bool is_available = false;
+
+  /**
+   * @brief number of allocations so far
+   */
+  tf::int64 num_allocs = 0;
+
+  /**
+   * @brief bytes currently allocated
+   */
+  tf::int64 bytes_in_use = 0;
+
+  /**
+   * @brief maximum bytes allocated at once so far
+   */
+  tf::int64 peak_bytes_in_use = 0;
+
+  /**
+   * @brief largest single allocation so far
+   */
+  tf::int64 largest_alloc_size = 0;
+
+  /**
+   * @brief size of the memory arena (0: unknown)
+   */
+  tf::int64 bytes_limit = 0;
+
+  /**
+   * @brief largest contiguous free block inside the arena
+   */
+  tf::int64 largest_free_block_bytes = 0;
+
+  /**
+   * @brief Determines the fragmentation of the free arena memory.
+   *
+   * Meaningful once the arena is fully reserved, see
+   * `SessionConfig::preallocate_gpu_memory`.
+   *
+   * @return  double  share of free memory outside of the largest free block
+   * (0: unfragmented)
+   */
+  double fragmentation() const {
+
+    const tf::int64 free_bytes = bytes_limit - bytes_in_use;
+    if (free_bytes <= 0) return 0.0;
+
+    return 1.0 - static_cast<double>(largest_free_block_bytes) / free_bytes;
+  }
+};
+
+
+/**
+ * @brief Determines the memory statistics of a session device.
+ *
+ * @param[in]  session       session
+ * @param[in]  device_name   full or local device name, e.g. "/device:GPU:0"
+ *
+ * @return  MemoryStats      memory statistics
+ */
+inline MemoryStats getSessionDeviceMemoryStats(tf::Session* session,
+                                               const std::string& device_name) {
+
+  MemoryStats stats;
+  const auto allocator_stats =
+    getSessionDeviceAllocator(session, device_name)->GetStats();
+  if (!allocator_stats) return stats;
+  stats.is_available = true;
+  stats.num_allocs = allocator_stats->num_allocs;
+  stats.bytes_in_use = allocator_stats->bytes_in_use;
+  stats.peak_bytes_in_use = allocator_stats->peak_bytes_in_use;
+  stats.largest_alloc_size = allocator_stats->largest_alloc_size;
+  stats.bytes_limit = allocator_stats->bytes_limit.value_or(0);
+  stats.largest_free_block_bytes = allocator_stats->largest_free_block_bytes;
+
+  return stats;
+}
+
+
+/**
+ * @brief Reserves the memory arena of a session device.
+ *
+ * Allocators growing on demand (see `SessionConfig::allow_growth`) only
+ * reserve memory as needed, otherwise the first allocation reserves the
+ * full arena, which is triggered here.
+ *
+ * @param[in]  session       session
+ * @param[in]  device_name   full or local device name, e.g. "/device:GPU:0"
+ */
+inline void reserveSessionDeviceMemory(tf::Session* session,
+                                       const std::string& device_name) {
+
+  tf::Allocator* allocator = getSessionDeviceAllocator(session, device_name);
+  void* ptr = allocator->AllocateRaw(tf::Allocator::kAllocatorAlignment, 1);
+  if (!ptr)
+    throw std::runtime_error("Failed to reserve memory on device '" +
+                             device_name + "'");
+  allocator->DeallocateRaw(ptr);
+}
+
+
+}  // namespace tensorflow_cpp
@@ -0,0 +1,382 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utility functions for optimizing FrozenGraphs for inference
+ */
+
+#pragma once
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/framework/tensor.pb.h>
+#include <tensorflow/core/grappler/clusters/utils.h>
+#include <tensorflow/core/grappler/clusters/virtual_cluster.h>
+#include <tensorflow/core/grappler/grappler_item.h>
+#include <tensorflow/core/grappler/optimizers/meta_optimizer.h>
+#include <tensorflow/core/platform/env.h>
+#include <tensorflow/core/platform/hash.h>
+#include <tensorflow/core/platform/path.h>
+#include <tensorflow_cpp/graph_utils.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Prunes a graph to the nodes needed to compute the given outputs.
+ *
+ * Placeholders are always kept, so that the inputs of the graph remain the
+ * same even if some of them do not contribute to any output.
+ *
+ * @param[in]  graph_def        graph
+ * @param[in]  output_names     output node names
+ *
+ * @return  tf::GraphDef        pruned graph
+ */
+inline tf::GraphDef pruneGraph(const tf::GraphDef& graph_def,
+                               const std::vector<std::string>& output_names) {
+
+  std::unordered_map<std::string, const tf::NodeDef*> nodes;
+  for (const tf::NodeDef& node : graph_def.node()) nodes[node.name()] = &node;
+
+  // traverse inputs, including control dependencies, from outputs
+  std::unordered_set<std::string> required;
+  std::vector<std::string> pending = output_names;
+  while (!pending.empty()) {
+    const std::string name = pending.back();
+    pending.pop_back();
+    const auto node = nodes.find(name);
+    if (node == nodes.end() || !required.insert(name).second) continue;
+    for (const std::string& input : node->second->input())
+      pending.push_back(GraphIndex::inputNodeName(input));
+  }
+
+  tf::GraphDef pruned;
+  *pruned.mutable_versions() = graph_def.versions();
+  *pruned.mutable_library() = graph_def.library();
+  for (const tf::NodeDef& node : graph_def.node()) {
+    if (required.count(node.name()) > 0 || node.op() == "Placeholder")
+      *pruned.add_node() = node;
+  }
+
+  return pruned;
+}
+
+
+/**
+ * @brief Creates a `Const` node holding a tensor.
+ *
+ * @param[in]  name          node name
+ * @param[in]  value         constant value
+ * @param[in]  device        node device
+ *
+ * @return  tf::NodeDef      node
+ */
+inline tf::NodeDef makeConstNode(const std::string& name,
+                                 const tf::Tensor& value,
+                                 const std::string& device = "") {
+
+  tf::NodeDef node;
+  node.set_name(name);
+  node.set_op("Const");
+  node.set_device(device);
+  (*node.mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent((*node.mutable_attr())["value"].mutable_tensor());
+
+  return node;
+}
+
+
+/**
+ * @brief Folds inference-mode batch norms into the preceding convolutions.
+ *
+ * A `FusedBatchNorm` (V1-V3) in NHWC format with constant parameters that
+ * follows a `Conv2D` with constant float filter, which is not consumed
+ * elsewhere, is folded into the filter; the batch norm node is replaced by a
+ * `BiasAdd` of the same name. Constants may be read through `Identity`
+ * nodes. The original filters are left for pruning.
+ *
+ * @param[in,out]  graph_def  graph
+ *
+ * @return  int               number of folded batch norms
+ */
+inline int foldBatchNorms(tf::GraphDef* graph_def) {
+
+  std::unordered_map<std::string, tf::NodeDef*> nodes;
+  for (tf::NodeDef& node : *graph_def->mutable_node())
+    nodes[node.name()] = &node;
+
+  // count consumers and find nodes whose secondary outputs are used
+  std::unordered_map<std::string, int> n_consumers;
+  std::unordered_set<std::string> secondary_outputs_used;
+  for (const tf::NodeDef& node : graph_def->node()) {
+    for (const std::string& input : node.input()) {
+      const std::string name = GraphIndex::inputNodeName(input);
+      n_consumers[name]++;
+      if (input[0] != '^' && input != name && input != name + ":0")
+        secondary_outputs_used.insert(name);
+    }
+  }
+
+  auto findNode = [&nodes](const std::string& input) -> tf::NodeDef* {
+    const auto node = nodes.find(GraphIndex::inputNodeName(input));
+    return (node != nodes.end()) ? node->second : nullptr;
+  };
+  auto constValue = [&findNode](const std::string& input, tf::Tensor* value) {
+    const tf::NodeDef* node = findNode(input);
+    while (node && node->op() == "Identity" && node->input_size() > 0)
+      node = findNode(node->input(0));
+    if (!node || node->op() != "Const" || node->attr().count("value") == 0)
+      return false;
+    return value->FromProto(node->attr().at("value").tensor()) &&
+           value->dtype() == tf::DT_FLOAT;
+  };
+  auto isNhwc = [](const tf::NodeDef& node) {
+    const auto format = node.attr().find("data_format");
+    return format == node.attr().end() || format->second.s() == "NHWC";
+  };
+
+  std::vector<tf::NodeDef> folded_constants;
+  int n_folded = 0;
+  for (int k = 0; k < graph_def->node_size(); k++) {
+    tf::NodeDef& bn = *graph_def->mutable_node(k);
+    if (bn.op() != "FusedBatchNorm" && bn.op() != "FusedBatchNormV2" &&
+        bn.op() != "FusedBatchNormV3")
+      continue;
+    const auto is_training = bn.attr().find("is_training");
+    if (is_training == bn.attr().end() || is_training->second.b()) continue;
+    if (!isNhwc(bn) || bn.input_size() < 5 ||
+        secondary_outputs_used.count(bn.name()) > 0)
+      continue;
+    tf::NodeDef* conv = findNode(bn.input(0));
+    if (!conv || conv->op() != "Conv2D" || !isNhwc(*conv) ||
+        n_consumers[conv->name()] != 1 ||
+        GraphIndex::inputNodeName(bn.input(0)) != bn.input(0))
+      continue;
+    tf::Tensor filter, scale, offset, mean, variance;
+    if (!constValue(conv->input(1), &filter) ||
+        !constValue(bn.input(1), &scale) ||
+        !constValue(bn.input(2), &offset) ||
+        !constValue(bn.input(3), &mean) ||
+        !constValue(bn.input(4), &variance) || filter.dims() != 4)
+      continue;
+    const tf::int64 n_channels = filter.dim_size(3);
+    if (scale.NumElements() != n_channels ||
+        offset.NumElements() != n_channels ||
+        mean.NumElements() != n_channels ||
+        variance.NumElements() != n_channels)
+      continue;
+    const auto epsilon_attr = bn.attr().find("epsilon");
+    const float epsilon =
+      (epsilon_attr != bn.attr().end()) ? epsilon_attr->second.f() : 1e-4f;
+
+    // y = (conv(x, w) - mean) * scale / sqrt(var + eps) + offset
+    //   = conv(x, w * s) + (offset - mean * s)
+    tf::Tensor folded_filter(tf::DT_FLOAT, filter.shape());
+    tf::Tensor bias(tf::DT_FLOAT, tf::TensorShape({n_channels}));
+    std::vector<float> factors(n_channels);
+    for (tf::int64 c = 0; c < n_channels; c++) {
+      factors[c] = scale.flat<float>()(c) /
+                   std::sqrt(variance.flat<float>()(c) + epsilon);
+      bias.flat<float>()(c) =
+        offset.flat<float>()(c) - mean.flat<float>()(c) * factors[c];
+    }
+    const auto weights = filter.flat<float>();
+    auto folded_weights = folded_filter.flat<float>();
+    for (tf::int64 i = 0; i < weights.size(); i++)
+      folded_weights(i) = weights(i) * factors[i % n_channels];
+
+    const std::string filter_name = bn.name() + "/folded_filter";
+    const std::string bias_name = bn.name() + "/folded_bias";
+    folded_constants.push_back(
+      makeConstNode(filter_name, folded_filter, conv->device()));
+    folded_constants.push_back(makeConstNode(bias_name, bias, bn.device()));
+    conv->set_input(1, filter_name);
+
+    // replace batch norm by bias addition, keeping control dependencies
+    tf::NodeDef bias_add;
+    bias_add.set_name(bn.name());
+    bias_add.set_op("BiasAdd");
+    bias_add.set_device(bn.device());
+    bias_add.add_input(bn.input(0));
+    bias_add.add_input(bias_name);
+    for (const std::string& input : bn.input())
+      if (input[0] == '^') bias_add.add_input(input);
+    (*bias_add.mutable_attr())["T"].set_type(tf::DT_FLOAT);
+    (*bias_add.mutable_attr())["data_format"].set_s("NHWC");
+    bn.Swap(&bias_add);
+    n_folded++;
+  }
+  for (tf::NodeDef& node : folded_constants) graph_def->add_node()->Swap(&node);
+
+  return n_folded;
+}
+
+
+/**
+ * @brief Runs Grappler's device-independent inference optimizations.
+ *
+ * Strips debug ops (e.g. `Assert`, `CheckNumerics`), removes `Identity`
+ * chains and no-ops, folds constants and simplifies arithmetic. Inputs and
+ * outputs are preserved. Device-specific rewrites such as layout
+ * optimization and op fusion are left to session creation.
+ *
+ * @param[in]  graph_def        graph
+ * @param[in]  input_names      input node names
+ * @param[in]  output_names     output node names
+ *
+ * @return  tf::GraphDef        optimized graph
+ */
+inline tf::GraphDef runGrapplerOptimizations(
+  const tf::GraphDef& graph_def, const std::vector<std::string>& input_names,
+  const std::vector<std::string>& output_names) {
+
+  tf::grappler::GrapplerItem item;
+  item.id = "tensorflow_cpp";
+  item.graph = graph_def;
+  for (const auto& name : input_names)
+    item.feed.emplace_back(name, tf::Tensor());
+  item.fetch = output_names;
+
+  tf::ConfigProto config_proto;
+  tf::RewriterConfig* rewrite_options =
+    config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewrite_options->set_min_graph_nodes(-1);
+  for (const char* optimizer :
+       {"debug_stripper", "pruning", "constfold", "arithmetic", "dependency"})
+    rewrite_options->add_optimizers(optimizer);
+
+  tf::grappler::VirtualCluster cluster(
+    {{"/job:localhost/replica:0/task:0/device:CPU:0",
+      tf::grappler::GetLocalCPUInfo()}});
+  tf::Status status = cluster.Provision();
+  tf::GraphDef optimized;
+  if (status.ok())
+    status = tf::grappler::RunMetaOptimizer(std::move(item), config_proto,
+                                            nullptr, &cluster, &optimized);
+  if (!status.ok())
+    throw std::runtime_error("Failed to optimize graph: " + status.ToString());
+
+  return optimized;
+}
+
+
+/**
+ * @brief Optimizes a FrozenGraph for inference.
+ *
+ * Prunes the graph to the subgraph needed for its outputs, folds batch norms
+ * into convolutions and runs Grappler's device-independent optimizations, see
+ * `pruneGraph`, `foldBatchNorms` and `runGrapplerOptimizations`.
+ *
+ * @param[in]  graph_def        graph
+ * @param[in]  input_names      input node names
+ * @param[in]  output_names     output node names
+ *
+ * @return  tf::GraphDef        optimized graph
+ */
+inline tf::GraphDef optimizeFrozenGraph(
+  const tf::GraphDef& graph_def, const std::vector<std::string>& input_names,
+  const std::vector<std::string>& output_names) {
+
+  tf::GraphDef optimized = pruneGraph(graph_def, output_names);
+  if (foldBatchNorms(&optimized) > 0)
+    optimized = pruneGraph(optimized, output_names);
+
+  return runGrapplerOptimizations(optimized, input_names, output_names);
+}
+
+
+/**
+ * @brief Loads a TensorFlow graph from a frozen graph file and optimizes it
+ * for inference, see `optimizeFrozenGraph`.
+ *
+ * Inputs and outputs are discovered via `GraphIndex`. If `cache_dir` is set,
+ * the optimized graph is cached there, keyed by a hash of the file contents,
+ * and loaded from the cache on subsequent calls. Caching is best-effort,
+ * failing to write the cache does not fail loading.
+ *
+ * @param[in]  file          frozen graph file
+ * @param[in]  cache_dir     directory for caching optimized graphs (empty:
+ *                           no caching)
+ *
+ * @return  tf::GraphDef     optimized graph
+ */
+inline tf::GraphDef loadOptimizedFrozenGraph(
+  const std::string& file, const std::string& cache_dir = "") {
+
+  tf::Env* env = tf::Env::Default();
+  std::string contents;
+  tf::Status status = tf::ReadFileToString(env, file, &contents);
+  if (!status.ok())
+    throw std::runtime_error("Failed to load frozen graph: " +
+                             status.ToString());
+
+  std::string cache_file;
+  tf::GraphDef graph_def;
+  if (!cache_dir.empty()) {
+    std::stringstream cache_name;
+    cache_name << "frozen_graph_" << std::hex << std::setw(16)
+               << std::setfill('0') << tf::Hash64(contents) << ".pb";
+    cache_file = tf::io::JoinPath(cache_dir, cache_name.str());
+    if (env->FileExists(cache_file).ok() &&
+        tf::ReadBinaryProto(env, cache_file, &graph_def).ok())
+      return graph_def;
+    graph_def.Clear();
+  }
+
+  if (!graph_def.ParseFromString(contents))
+    throw std::runtime_error("Failed to load frozen graph: cannot parse " +
+                             file);
+  contents.clear();
+  const GraphIndex index(graph_def);
+  graph_def =
+    optimizeFrozenGraph(graph_def, index.inputNames(), index.outputNames());
+
+  // write to a temporary file first, so that readers never see partial files
+  if (!cache_file.empty() && env->RecursivelyCreateDir(cache_dir).ok()) {
+    const std::string tmp_file =
+      cache_file + ".tmp" + std::to_string(env->NowMicros());
+    if (tf::WriteBinaryProto(env, tmp_file, graph_def).ok() &&
+        !env->RenameFile(tmp_file, cache_file).ok())
+      env->DeleteFile(tmp_file).IgnoreError();
+  }
+
+  return graph_def;
+}
+
+
+}  // namespace tensorflow_cpp
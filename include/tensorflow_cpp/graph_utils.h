@@ -31,9 +31,12 @@ SOFTWARE.
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <tensorflow/core/platform/env.h>
+#include <tensorflow/core/util/memmapped_file_system.h>
 #include <tensorflow_cpp/utils.h>
 
 
@@ -62,6 +65,74 @@ inline tf::GraphDef loadFrozenGraph(const std::string& file) {
 }
 
 
+/**
+ * @brief Loads a TensorFlow graph from a frozen graph file in memmapped file
+ * system format.
+ *
+ * Such files are created from frozen graphs by TensorFlow's
+ * `convert_graphdef_memmapped_format` tool. Constant weights are not part of
+ * the returned graph, but mapped into memory by `env`. Sessions running the
+ * graph need to be created with `env`, see `createSession`.
+ *
+ * @param[in]  file          memmapped frozen graph file
+ * @param[in]  env           memmapped environment to initialize
+ *
+ * @return  tf::GraphDef     graph
+ */
+inline tf::GraphDef loadMemmappedFrozenGraph(const std::string& file,
+                                             tf::MemmappedEnv* env) {
+
+  tf::Status status = env->InitializeFromFile(file);
+  if (!status.ok())
+    throw std::runtime_error("Failed to map frozen graph: " +
+                             status.ToString());
+  tf::GraphDef graph_def;
+  status = tf::ReadBinaryProto(
+    env, tf::MemmappedFileSystem::kMemmappedPackageDefaultGraphDef, &graph_def);
+  if (!status.ok())
+    throw std::runtime_error("Failed to load memmapped frozen graph: " +
+                             status.ToString());
+
+  return graph_def;
+}
+
+
+/**
+ * @brief Extracts the given nodes from a graph, without their inputs.
+ *
+ * @param[in]  graph_def        graph
+ * @param[in]  node_names       names of nodes to extract
+ *
+ * @return  tf::GraphDef        graph containing only the given nodes
+ */
+inline tf::GraphDef extractGraphNodes(
+  const tf::GraphDef& graph_def, const std::vector<std::string>& node_names) {
+
+  const std::unordered_set<std::string> names(node_names.begin(),
+                                              node_names.end());
+  tf::GraphDef extracted;
+  for (const tf::NodeDef& node : graph_def.node()) {
+    if (names.count(node.name()) > 0) *extracted.add_node() = node;
+  }
+
+  return extracted;
+}
+
+
+/**
+ * @brief Places all nodes of a graph without explicit placement on a device.
+ *
+ * @param[in]  graph_def        graph
+ * @param[in]  device           device name, e.g. "/device:GPU:1"
+ */
+inline void placeGraphOnDevice(tf::GraphDef* graph_def,
+                               const std::string& device) {
+
+  for (tf::NodeDef& node : *graph_def->mutable_node())
+    if (node.device().empty()) node.set_device(device);
+}
+
+
 /**
  * @brief Loads a TensorFlow graph into an existing session.
  *
@@ -82,6 +153,26 @@ inline bool loadGraphIntoSession(tf::Session* session,
   return true;
 }
 
+/**
+ * @brief Loads a TensorFlow graph from a frozen graph file into a new
+ * session.
+ *
+ * @param[in]  file             frozen graph file
+ * @param[in]  config           session configuration
+ *
+ * @return  tf::Session*        session
+ */
+inline tf::Session* loadFrozenGraphIntoNewSession(const std::string& file,
+                                                  const SessionConfig& config) {
+
+  tf::GraphDef graph_def = loadFrozenGraph(file);
+  tf::Session* session = createSession(config);
+  if (!loadGraphIntoSession(session, graph_def)) return nullptr;
+
+  return session;
+}
+
+
 /**
  * @brief Loads a TensorFlow graph from a frozen graph file into a new
  * session.
@@ -91,21 +182,242 @@ inline bool loadGraphIntoSession(tf::Session* session,
  * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
  * @param[in]  visible_device_list              list of GPUs to use, e.g.
  * "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
  *
  * @return  tf::Session*                        session
  */
 inline tf::Session* loadFrozenGraphIntoNewSession(
   const std::string& file, const bool allow_growth = true,
   const double per_process_gpu_memory_fraction = 0,
-  const std::string& visible_device_list = "") {
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
+
+  return loadFrozenGraphIntoNewSession(
+    file, makeSessionConfig(allow_growth, per_process_gpu_memory_fraction,
+                            visible_device_list, intra_op_parallelism_threads,
+                            inter_op_parallelism_threads));
+}
 
-  tf::GraphDef graph_def = loadFrozenGraph(file);
-  tf::Session* session = createSession(
-    allow_growth, per_process_gpu_memory_fraction, visible_device_list);
-  if (!loadGraphIntoSession(session, graph_def)) return nullptr;
 
-  return session;
-}
+/**
+ * @brief Index of graph metadata for constant-time queries by node name.
+ *
+ * Built in a single pass over a graph, it holds everything needed to query
+ * inputs, outputs, shapes, types and consumers of nodes. The index copies the
+ * metadata, so it stays valid if the graph is modified or released later.
+ */
+class GraphIndex {
+
+ public:
+  /**
+   * @brief Metadata of a single graph node.
+   */
+  struct Node {
+
+    /**
+     * @brief position of the node in the graph
+     */
+    int index = -1;
+
+    /**
+     * @brief op type
+     */
+    std::string op;
+
+    /**
+     * @brief shape attribute (empty if none)
+     */
+    std::vector<int> shape;
+
+    /**
+     * @brief dtype attribute (DT_INVALID if none)
+     */
+    tf::DataType dtype = tf::DT_INVALID;
+
+    /**
+     * @brief names of nodes consuming any output of this node, including
+     * control dependencies
+     */
+    std::vector<std::string> consumers;
+  };
+
+  /**
+   * @brief Creates an empty index.
+   */
+  GraphIndex() {}
+
+  /**
+   * @brief Indexes a graph.
+   *
+   * @param[in]  graph_def  graph
+   */
+  explicit GraphIndex(const tf::GraphDef& graph_def) {
+
+    nodes_.reserve(graph_def.node_size());
+    int idx = 0;
+    for (const tf::NodeDef& node : graph_def.node()) {
+      Node& info = nodes_[node.name()];
+      info.index = idx++;
+      info.op = node.op();
+      const auto shape_attr = node.attr().find("shape");
+      if (shape_attr != node.attr().end()) {
+        const auto& shape = shape_attr->second.shape();
+        for (int d = 0; d < shape.dim_size(); d++)
+          info.shape.push_back(shape.dim(d).size());
+      }
+      const auto dtype_attr = node.attr().find("dtype");
+      if (dtype_attr != node.attr().end())
+        info.dtype = dtype_attr->second.type();
+      if (node.op() == "Placeholder") input_names_.push_back(node.name());
+    }
+
+    // inputs reference nodes as "name", "name:port" or "^name" (control)
+    for (const tf::NodeDef& node : graph_def.node()) {
+      for (const std::string& input : node.input()) {
+        const auto producer = nodes_.find(inputNodeName(input));
+        if (producer != nodes_.end())
+          producer->second.consumers.push_back(node.name());
+      }
+    }
+
+    // outputs are unconsumed nodes, except for ops unlikely to be outputs
+    const std::unordered_set<std::string> unlikely_output_ops = {
+      "Const", "Assign", "NoOp", "Placeholder", "Assert"};
+    for (const tf::NodeDef& node : graph_def.node()) {
+      const Node& info = nodes_.at(node.name());
+      if (info.consumers.empty() && unlikely_output_ops.count(info.op) == 0)
+        output_names_.push_back(node.name());
+    }
+  }
+
+  /**
+   * @brief Strips port and control dependency marker from a node input.
+   *
+   * @param[in]  input        node input, e.g. "name:1" or "^name"
+   *
+   * @return  std::string     node name
+   */
+  static std::string inputNodeName(const std::string& input) {
+
+    const size_t begin = (!input.empty() && input[0] == '^') ? 1 : 0;
+    const size_t port = input.rfind(':');
+    const size_t end =
+      (port != std::string::npos && port >= begin) ? port : input.size();
+
+    return input.substr(begin, end - begin);
+  }
+
+  /**
+   * @brief Looks up the metadata of a node.
+   *
+   * @param[in]  node_name     node name
+   *
+   * @return  const Node*      node metadata (nullptr if not found)
+   */
+  const Node* node(const std::string& node_name) const {
+
+    const auto it = nodes_.find(node_name);
+    return (it != nodes_.end()) ? &it->second : nullptr;
+  }
+
+  /**
+   * @brief Checks whether the graph contains a node.
+   *
+   * @param[in]  node_name  node name
+   *
+   * @return  true          if node exists
+   * @return  false         otherwise
+   */
+  bool contains(const std::string& node_name) const {
+    return nodes_.count(node_name) > 0;
+  }
+
+  /**
+   * @brief Returns the number of indexed nodes.
+   *
+   * @return  int  number of nodes
+   */
+  int size() const {
+    return nodes_.size();
+  }
+
+  /**
+   * @brief Returns the names of all graph input nodes, see
+   * `getGraphInputNames`.
+   *
+   * @return  const std::vector<std::string>&  input node names
+   */
+  const std::vector<std::string>& inputNames() const {
+    return input_names_;
+  }
+
+  /**
+   * @brief Returns the names of all graph output nodes, see
+   * `getGraphOutputNames`.
+   *
+   * @return  const std::vector<std::string>&  output node names
+   */
+  const std::vector<std::string>& outputNames() const {
+    return output_names_;
+  }
+
+  /**
+   * @brief Returns the shape of a node.
+   *
+   * @param[in]  node_name         node name
+   *
+   * @return  std::vector<int>     node shape (empty if unknown)
+   */
+  std::vector<int> nodeShape(const std::string& node_name) const {
+
+    const Node* info = node(node_name);
+    return info ? info->shape : std::vector<int>();
+  }
+
+  /**
+   * @brief Returns the datatype of a node.
+   *
+   * @param[in]  node_name     node name
+   *
+   * @return  tf::DataType     node datatype (DT_INVALID if unknown)
+   */
+  tf::DataType nodeType(const std::string& node_name) const {
+
+    const Node* info = node(node_name);
+    return info ? info->dtype : tf::DT_INVALID;
+  }
+
+  /**
+   * @brief Returns the names of all nodes consuming outputs of a node.
+   *
+   * @param[in]  node_name                 node name
+   *
+   * @return  std::vector<std::string>     consumer node names
+   */
+  std::vector<std::string> consumers(const std::string& node_name) const {
+
+    const Node* info = node(node_name);
+    return info ? info->consumers : std::vector<std::string>();
+  }
+
+ protected:
+  /**
+   * @brief node metadata by node name
+   */
+  std::unordered_map<std::string, Node> nodes_;
+
+  /**
+   * @brief input node names in graph order
+   */
+  std::vector<std::string> input_names_;
+
+  /**
+   * @brief output node names in graph order
+   */
+  std::vector<std::string> output_names_;
+};
 
 
 /**
@@ -130,6 +442,9 @@ inline std::vector<std::string> getGraphInputNames(
 /**
  * @brief Determines the names of all graph output nodes.
  *
+ * Output nodes are nodes whose outputs are not consumed by any other node,
+ * except for ops that are unlikely to be outputs, e.g. `Const` or `NoOp`.
+ *
  * @param[in]  graph_def                 graph
  *
  * @return  std::vector<std::string>     list of output node names
@@ -137,29 +452,15 @@ inline std::vector<std::string> getGraphInputNames(
 inline std::vector<std::string> getGraphOutputNames(
   const tf::GraphDef& graph_def) {
 
-  std::vector<std::string> output_nodes;
-  std::vector<std::string> nodes_with_outputs;
-  std::unordered_set<std::string> unlikely_output_ops = {"Const", "Assign",
-                                                         "NoOp", "Placeholder",
-                                                         "Assert"};
-  for (const tf::NodeDef& node : graph_def.node()) {
-    for (const std::string& input_name : node.input())
-      nodes_with_outputs.push_back(input_name);
-  }
-  for (const tf::NodeDef& node : graph_def.node()) {
-    if (std::find(nodes_with_outputs.begin(), nodes_with_outputs.end(),
-                  node.name()) == nodes_with_outputs.end() &&
-        unlikely_output_ops.count(node.op()) == 0)
-      output_nodes.push_back(node.name());
-  }
-
-  return output_nodes;
+  return GraphIndex(graph_def).outputNames();
 }
 
 
 /**
  * @brief Determines the shape of a given graph node.
  *
+ * For repeated queries, build a `GraphIndex` once instead.
+ *
  * @param[in]  graph_def         graph
  * @param[in]  node_name         node name
  *
@@ -186,6 +487,8 @@ inline std::vector<int> getGraphNodeShape(const tf::GraphDef& graph_def,
 /**
  * @brief Determines the datatype of a given graph node.
  *
+ * For repeated queries, build a `GraphIndex` once instead.
+ *
  * @param[in]  graph_def     graph
  * @param[in]  node_name     node name
  *
@@ -214,22 +517,22 @@ inline tf::DataType getGraphNodeType(const tf::GraphDef& graph_def,
  *
  * Currently limited to single-output graphs.
  *
- * @param[in]  graph_def  graph
+ * @param[in]  index      graph index
  *
  * @return  std::string   formatted info message
  */
-inline std::string getGraphInfoString(const tf::GraphDef& graph_def) {
+inline std::string getGraphInfoString(const GraphIndex& index) {
 
   std::stringstream ss;
   ss << "FrozenGraph Info:" << std::endl;
 
-  const std::vector<std::string> inputs = getGraphInputNames(graph_def);
-  const std::vector<std::string> outputs = getGraphOutputNames(graph_def);
+  const std::vector<std::string>& inputs = index.inputNames();
+  const std::vector<std::string>& outputs = index.outputNames();
 
   ss << "Inputs: " << inputs.size() << std::endl;
   for (const auto& name : inputs) {
-    const auto& shape = getGraphNodeShape(graph_def, name);
-    const auto& dtype = getGraphNodeType(graph_def, name);
+    const auto& shape = index.nodeShape(name);
+    const auto& dtype = index.nodeType(name);
     ss << "  " << name << std::endl;
     ss << "    Shape: [ ";
     for (int d = 0; d < shape.size(); d++) {
@@ -241,8 +544,8 @@ inline std::string getGraphInfoString(const tf::GraphDef& graph_def) {
 
   ss << "Outputs: " << outputs.size() << std::endl;
   for (const auto& name : outputs) {
-    const auto& shape = getGraphNodeShape(graph_def, name);
-    const auto& dtype = getGraphNodeType(graph_def, name);
+    const auto& shape = index.nodeShape(name);
+    const auto& dtype = index.nodeType(name);
     ss << "  " << name << std::endl;
     ss << "    Shape: [ ";
     for (int d = 0; d < shape.size(); d++) {
@@ -256,4 +559,19 @@ inline std::string getGraphInfoString(const tf::GraphDef& graph_def) {
 }
 
 
+/**
+ * Returns information about a FrozenGraph model.
+ *
+ * See `getGraphInfoString(const GraphIndex&)`.
+ *
+ * @param[in]  graph_def  graph
+ *
+ * @return  std::string   formatted info message
+ */
+inline std::string getGraphInfoString(const tf::GraphDef& graph_def) {
+
+  return getGraphInfoString(GraphIndex(graph_def));
+}
+
+
 }  // namespace tensorflow_cpp
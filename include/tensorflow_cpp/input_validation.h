@@ -0,0 +1,263 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utilities for validating and converting model inputs
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/framework/types.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Expected datatype and shape of a model input.
+ */
+struct InputSpec {
+
+  /**
+   * @brief input name
+   */
+  std::string name;
+
+  /**
+   * @brief datatype (DT_INVALID: any datatype)
+   */
+  tf::DataType dtype = tf::DT_INVALID;
+
+  /**
+   * @brief shape, -1 for unknown dimensions (empty: any shape)
+   */
+  std::vector<int> shape;
+};
+
+
+/**
+ * @brief Checks whether a tensor matches an input spec.
+ *
+ * @param[in]  spec    input spec
+ * @param[in]  tensor  tensor
+ *
+ * @return  true       if datatype and shape match
+ * @return  false      otherwise
+ */
+inline bool matchesInputSpec(const InputSpec& spec, const tf::Tensor& tensor) {
+
+  if (spec.dtype != tf::DT_INVALID && tensor.dtype() != spec.dtype)
+    return false;
+  if (spec.shape.empty()) return true;
+  if (tensor.dims() != spec.shape.size()) return false;
+  for (int d = 0; d < spec.shape.size(); d++)
+    if (spec.shape[d] >= 0 && tensor.dim_size(d) != spec.shape[d])
+      return false;
+
+  return true;
+}
+
+
+/**
+ * @brief Describes why a tensor does not match an input spec.
+ *
+ * @param[in]  spec    input spec
+ * @param[in]  tensor  tensor
+ *
+ * @return  std::string  error message
+ */
+inline std::string describeInputMismatch(const InputSpec& spec,
+                                         const tf::Tensor& tensor) {
+
+  std::string shape = "[";
+  for (int d = 0; d < spec.shape.size(); d++)
+    shape += (d > 0 ? "," : "") + std::to_string(spec.shape[d]);
+  shape += "]";
+
+  return "Model input '" + spec.name + "' expects datatype " +
+         tf::DataTypeString(spec.dtype) + " and shape " + shape +
+         ", but got tensor of datatype " + tf::DataTypeString(tensor.dtype()) +
+         " and shape " + tensor.shape().DebugString();
+}
+
+
+/**
+ * @brief Throws if a tensor does not match an input spec.
+ *
+ * @param[in]  spec    input spec
+ * @param[in]  tensor  tensor
+ */
+inline void validateInput(const InputSpec& spec, const tf::Tensor& tensor) {
+
+  if (!matchesInputSpec(spec, tensor))
+    throw std::runtime_error(describeInputMismatch(spec, tensor));
+}
+
+
+/**
+ * @brief Casts all elements of a tensor, see `castTensor`.
+ *
+ * @param[in]   src  source tensor of datatype `S`
+ * @param[out]  dst  destination tensor of the same shape
+ */
+template <typename S>
+inline void castTensorFrom(const tf::Tensor& src, tf::Tensor& dst) {
+
+  // Eigen evaluates the cast with packet math where available
+#define TENSORFLOW_CPP_CAST_TO(T)                     \
+  case tf::DataTypeToEnum<T>::value:                  \
+    dst.flat<T>() = src.flat<S>().template cast<T>(); \
+    return;
+
+  switch (dst.dtype()) {
+    TENSORFLOW_CPP_CAST_TO(float)
+    TENSORFLOW_CPP_CAST_TO(double)
+    TENSORFLOW_CPP_CAST_TO(Eigen::half)
+    TENSORFLOW_CPP_CAST_TO(tf::bfloat16)
+    TENSORFLOW_CPP_CAST_TO(tf::int8)
+    TENSORFLOW_CPP_CAST_TO(tf::uint8)
+    TENSORFLOW_CPP_CAST_TO(tf::int16)
+    TENSORFLOW_CPP_CAST_TO(tf::uint16)
+    TENSORFLOW_CPP_CAST_TO(tf::int32)
+    TENSORFLOW_CPP_CAST_TO(tf::int64)
+    default:
+      throw std::runtime_error("Casting to datatype " +
+                               tf::DataTypeString(dst.dtype()) +
+                               " is not supported");
+  }
+
+#undef TENSORFLOW_CPP_CAST_TO
+}
+
+
+/**
+ * @brief Casts a tensor to another datatype.
+ *
+ * Supports float, double, half, bfloat16 and 8/16/32/64-bit integer tensors.
+ *
+ * @param[in]  tensor  tensor
+ * @param[in]  dtype   target datatype
+ *
+ * @return  tf::Tensor  tensor of target datatype (shared if already matching)
+ */
+inline tf::Tensor castTensor(const tf::Tensor& tensor,
+                             const tf::DataType dtype) {
+
+  if (tensor.dtype() == dtype) return tensor;
+
+#define TENSORFLOW_CPP_CAST_FROM(S)  \
+  case tf::DataTypeToEnum<S>::value: \
+    castTensorFrom<S>(tensor, cast); \
+    break;
+
+  tf::Tensor cast(dtype, tensor.shape());
+  switch (tensor.dtype()) {
+    TENSORFLOW_CPP_CAST_FROM(float)
+    TENSORFLOW_CPP_CAST_FROM(double)
+    TENSORFLOW_CPP_CAST_FROM(Eigen::half)
+    TENSORFLOW_CPP_CAST_FROM(tf::bfloat16)
+    TENSORFLOW_CPP_CAST_FROM(tf::int8)
+    TENSORFLOW_CPP_CAST_FROM(tf::uint8)
+    TENSORFLOW_CPP_CAST_FROM(tf::int16)
+    TENSORFLOW_CPP_CAST_FROM(tf::uint16)
+    TENSORFLOW_CPP_CAST_FROM(tf::int32)
+    TENSORFLOW_CPP_CAST_FROM(tf::int64)
+    default:
+      throw std::runtime_error("Casting from datatype " +
+                               tf::DataTypeString(tensor.dtype()) +
+                               " is not supported");
+  }
+
+#undef TENSORFLOW_CPP_CAST_FROM
+
+  return cast;
+}
+
+
+/**
+ * @brief Reshapes a tensor to match an input spec, without copying.
+ *
+ * Only leading dimensions of size 1 are added or dropped, e.g. a missing
+ * batch dimension. All other dimensions are kept as given, so that tensors of
+ * a different shape or layout still fail validation.
+ *
+ * @param[in]  spec    input spec
+ * @param[in]  tensor  tensor
+ *
+ * @return  tf::Tensor  reshaped tensor, sharing the tensor's buffer
+ */
+inline tf::Tensor reshapeToInputSpec(const InputSpec& spec,
+                                     const tf::Tensor& tensor) {
+
+  if (spec.shape.empty()) return tensor;
+
+  // drop excess leading dimensions of size 1
+  const int rank = spec.shape.size();
+  int first = 0;
+  while (tensor.dims() - first > rank && tensor.dim_size(first) == 1) first++;
+
+  // add missing leading dimensions of size 1
+  tf::TensorShape shape;
+  for (int d = tensor.dims() - first; d < rank; d++) shape.AddDim(1);
+  for (int d = first; d < tensor.dims(); d++) shape.AddDim(tensor.dim_size(d));
+
+  tf::Tensor reshaped;
+  if (shape == tensor.shape() || !reshaped.CopyFrom(tensor, shape))
+    return tensor;
+
+  return reshaped;
+}
+
+
+/**
+ * @brief Casts and reshapes a tensor to match an input spec.
+ *
+ * See `castTensor` and `reshapeToInputSpec`. Throws if the tensor still does
+ * not match afterwards.
+ *
+ * @param[in]  spec    input spec
+ * @param[in]  tensor  tensor
+ *
+ * @return  tf::Tensor  matching tensor
+ */
+inline tf::Tensor convertInput(const InputSpec& spec,
+                               const tf::Tensor& tensor) {
+
+  tf::Tensor converted = reshapeToInputSpec(spec, tensor);
+  if (spec.dtype != tf::DT_INVALID)
+    converted = castTensor(converted, spec.dtype);
+  validateInput(spec, converted);
+
+  return converted;
+}
+
+
+}  // namespace tensorflow_cpp
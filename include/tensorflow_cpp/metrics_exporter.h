@@ -0,0 +1,420 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief MetricsExporter class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/observer.h>
+
+
+namespace tensorflow_cpp {
+
+
+/**
+ * @brief Observer collecting per-model metrics in Prometheus text format.
+ *
+ * Records the number of runs, samples and errors, a latency histogram and
+ * the recent QPS of every observed model. Additional gauges, e.g. queue
+ * depths of batching or asynchronous models and GPU memory usage, are
+ * sampled on export. Serving the text returned by `exportText` on an HTTP
+ * endpoint is left to the application.
+ *
+ * Thread-safe, runs may be recorded concurrently.
+ */
+class MetricsExporter : public ModelObserver {
+
+ public:
+  /**
+   * @brief clock used for all time measurements
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Creates an exporter.
+   *
+   * @param[in]  histogram_bounds_ms  upper bounds of latency histogram
+   * buckets [ms]
+   * @param[in]  qps_window_s         window to average QPS over [s]
+   */
+  explicit MetricsExporter(
+    const std::vector<double>& histogram_bounds_ms = {0.1, 0.2, 0.5, 1, 2, 5,
+                                                      10, 20, 50, 100, 200,
+                                                      500, 1000},
+    const int qps_window_s = 10)
+      : histogram_bounds_ms_(histogram_bounds_ms),
+        qps_window_s_(std::max(1, qps_window_s)) {
+
+    std::sort(histogram_bounds_ms_.begin(), histogram_bounds_ms_.end());
+  }
+
+  /**
+   * @brief Records a finished session run.
+   *
+   * @param[in]  event  run event
+   */
+  void postRun(const RunEvent& event) override {
+
+    const int bucket =
+      std::lower_bound(histogram_bounds_ms_.begin(),
+                       histogram_bounds_ms_.end(), event.duration_ms) -
+      histogram_bounds_ms_.begin();
+    const long second = currentSecond();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ModelMetrics& metrics = metrics_[event.model_name];
+    if (metrics.histogram_counts.empty()) {
+      metrics.histogram_counts.resize(histogram_bounds_ms_.size() + 1, 0);
+      metrics.qps_counts.resize(qps_window_s_ + 1, 0);
+      metrics.qps_seconds.resize(qps_window_s_ + 1, -1);
+    }
+    metrics.n_runs++;
+    if (event.batch_size > 0) metrics.n_samples += event.batch_size;
+    if (!event.ok) metrics.n_errors++;
+    metrics.latency_sum_ms += event.duration_ms;
+    metrics.histogram_counts[bucket]++;
+    const int slot = second % metrics.qps_counts.size();
+    if (metrics.qps_seconds[slot] != second) {
+      metrics.qps_seconds[slot] = second;
+      metrics.qps_counts[slot] = 0;
+    }
+    metrics.qps_counts[slot]++;
+  }
+
+  /**
+   * @brief Adds a gauge sampled on every export.
+   *
+   * @param[in]  metric      metric name, e.g. "tensorflow_cpp_queue_size"
+   * @param[in]  model_name  model name used as label
+   * @param[in]  value       function returning the current value
+   * @param[in]  help        metric description
+   */
+  void addGauge(const std::string& metric, const std::string& model_name,
+                std::function<double()> value, const std::string& help = "") {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.push_back({metric, model_name, help, std::move(value)});
+  }
+
+  /**
+   * @brief Adds a gauge reporting the queue depth of a model.
+   *
+   * Works with any queue, e.g. `BatchingModel::queueSize` or
+   * `Model::asyncQueueSize`.
+   *
+   * @param[in]  model_name  model name used as label
+   * @param[in]  queue_size  function returning the current queue depth
+   */
+  void watchQueue(const std::string& model_name,
+                  std::function<int()> queue_size) {
+
+    addGauge(
+      "tensorflow_cpp_queue_size", model_name,
+      [queue_size]() { return static_cast<double>(queue_size()); },
+      "Number of requests waiting to be run.");
+  }
+
+  /**
+   * @brief Adds gauges reporting the device memory usage of a model.
+   *
+   * See `Model::memoryStats`. The model must outlive the exporter.
+   *
+   * @param[in]  model  model to watch, reported by `Model::name`
+   */
+  void watchMemory(const Model& model) {
+
+    const Model* m = &model;
+    addGauge(
+      "tensorflow_cpp_memory_bytes_in_use", model.name(),
+      [m]() { return static_cast<double>(m->memoryStats().bytes_in_use); },
+      "Bytes in use by the allocator of the model's device.");
+    addGauge(
+      "tensorflow_cpp_memory_peak_bytes_in_use", model.name(),
+      [m]() {
+        return static_cast<double>(m->memoryStats().peak_bytes_in_use);
+      },
+      "Peak bytes in use by the allocator of the model's device.");
+    addGauge(
+      "tensorflow_cpp_memory_bytes_limit", model.name(),
+      [m]() { return static_cast<double>(m->memoryStats().bytes_limit); },
+      "Memory limit of the allocator of the model's device.");
+  }
+
+  /**
+   * @brief Returns the recent QPS of a model.
+   *
+   * Averaged over the last `qps_window_s` completed seconds.
+   *
+   * @param[in]  model_name  model name
+   *
+   * @return  double         runs per second
+   */
+  double qps(const std::string& model_name) const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = metrics_.find(model_name);
+
+    return (it != metrics_.end()) ? qps(it->second, currentSecond()) : 0.0;
+  }
+
+  /**
+   * @brief Exports all metrics in Prometheus text exposition format.
+   *
+   * @return  std::string  metrics
+   */
+  std::string exportText() const {
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const long second = currentSecond();
+    std::ostringstream ss;
+
+    auto writeHeader = [&ss](const std::string& metric,
+                             const std::string& type,
+                             const std::string& help) {
+      if (!help.empty()) ss << "# HELP " << metric << " " << help << "\n";
+      ss << "# TYPE " << metric << " " << type << "\n";
+    };
+    auto writeCounter = [&](const std::string& metric, const std::string& help,
+                            const std::function<double(const ModelMetrics&)>&
+                              value) {
+      writeHeader(metric, "counter", help);
+      for (const auto& entry : metrics_)
+        ss << metric << "{model=\"" << escapeLabel(entry.first) << "\"} "
+           << value(entry.second) << "\n";
+    };
+
+    if (!metrics_.empty()) {
+      writeCounter("tensorflow_cpp_runs_total", "Number of session runs.",
+                   [](const ModelMetrics& m) { return m.n_runs; });
+      writeCounter("tensorflow_cpp_samples_total",
+                   "Number of samples along the batch dimension.",
+                   [](const ModelMetrics& m) { return m.n_samples; });
+      writeCounter("tensorflow_cpp_errors_total",
+                   "Number of failed session runs.",
+                   [](const ModelMetrics& m) { return m.n_errors; });
+
+      writeHeader("tensorflow_cpp_qps", "gauge",
+                  "Session runs per second, averaged over " +
+                    std::to_string(qps_window_s_) + " s.");
+      for (const auto& entry : metrics_)
+        ss << "tensorflow_cpp_qps{model=\"" << escapeLabel(entry.first)
+           << "\"} " << qps(entry.second, second) << "\n";
+
+      writeHeader("tensorflow_cpp_latency_ms", "histogram",
+                  "Wall time of session runs in milliseconds.");
+      for (const auto& entry : metrics_) {
+        const std::string label = escapeLabel(entry.first);
+        const ModelMetrics& m = entry.second;
+        long cumulative = 0;
+        for (int b = 0; b < m.histogram_counts.size(); b++) {
+          cumulative += m.histogram_counts[b];
+          ss << "tensorflow_cpp_latency_ms_bucket{model=\"" << label
+             << "\",le=\"";
+          if (b < histogram_bounds_ms_.size())
+            ss << histogram_bounds_ms_[b];
+          else
+            ss << "+Inf";
+          ss << "\"} " << cumulative << "\n";
+        }
+        ss << "tensorflow_cpp_latency_ms_sum{model=\"" << label << "\"} "
+           << m.latency_sum_ms << "\n";
+        ss << "tensorflow_cpp_latency_ms_count{model=\"" << label << "\"} "
+           << m.n_runs << "\n";
+      }
+    }
+
+    // gauges grouped by metric name, sampled without holding the lock
+    std::map<std::string, std::vector<Gauge>> gauges;
+    for (const auto& gauge : gauges_) gauges[gauge.metric].push_back(gauge);
+    lock.unlock();
+    for (const auto& entry : gauges) {
+      writeHeader(entry.first, "gauge", entry.second.front().help);
+      for (const Gauge& gauge : entry.second)
+        ss << entry.first << "{model=\"" << escapeLabel(gauge.model_name)
+           << "\"} " << gauge.value() << "\n";
+    }
+
+    return ss.str();
+  }
+
+ protected:
+  /**
+   * @brief Metrics collected for a single model.
+   */
+  struct ModelMetrics {
+
+    /**
+     * @brief number of session runs
+     */
+    long n_runs = 0;
+
+    /**
+     * @brief number of samples along the batch dimension
+     */
+    long n_samples = 0;
+
+    /**
+     * @brief number of failed session runs
+     */
+    long n_errors = 0;
+
+    /**
+     * @brief accumulated wall time of all runs [ms]
+     */
+    double latency_sum_ms = 0;
+
+    /**
+     * @brief number of runs per latency histogram bucket
+     */
+    std::vector<long> histogram_counts;
+
+    /**
+     * @brief number of runs per second, ring buffer indexed by second
+     */
+    std::vector<long> qps_counts;
+
+    /**
+     * @brief second each QPS slot was last counted in
+     */
+    std::vector<long> qps_seconds;
+  };
+
+  /**
+   * @brief Gauge sampled on export.
+   */
+  struct Gauge {
+
+    /**
+     * @brief metric name
+     */
+    std::string metric;
+
+    /**
+     * @brief model name used as label
+     */
+    std::string model_name;
+
+    /**
+     * @brief metric description
+     */
+    std::string help;
+
+    /**
+     * @brief function returning the current value
+     */
+    std::function<double()> value;
+  };
+
+  /**
+   * @brief Returns the current time in whole seconds.
+   *
+   * @return  long  seconds since clock epoch
+   */
+  static long currentSecond() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+             Clock::now().time_since_epoch())
+      .count();
+  }
+
+  /**
+   * @brief Escapes a Prometheus label value.
+   *
+   * @param[in]  value        label value
+   *
+   * @return  std::string     escaped label value
+   */
+  static std::string escapeLabel(const std::string& value) {
+
+    std::string escaped;
+    for (const char c : value) {
+      if (c == '\\' || c == '"') escaped += '\\';
+      if (c == '\n')
+        escaped += "\\n";
+      else
+        escaped += c;
+    }
+
+    return escaped;
+  }
+
+  /**
+   * @brief Computes the QPS over the last completed seconds.
+   *
+   * @param[in]  metrics  model metrics
+   * @param[in]  second   current second
+   *
+   * @return  double      runs per second
+   */
+  double qps(const ModelMetrics& metrics, const long second) const {
+
+    long n_runs = 0;
+    for (int slot = 0; slot < metrics.qps_counts.size(); slot++) {
+      const long age = second - metrics.qps_seconds[slot];
+      if (age >= 1 && age <= qps_window_s_) n_runs += metrics.qps_counts[slot];
+    }
+
+    return static_cast<double>(n_runs) / qps_window_s_;
+  }
+
+ protected:
+  /**
+   * @brief upper bounds of latency histogram buckets [ms]
+   */
+  std::vector<double> histogram_bounds_ms_;
+
+  /**
+   * @brief window to average QPS over [s]
+   */
+  int qps_window_s_ = 10;
+
+  /**
+   * @brief metrics by model name
+   */
+  std::map<std::string, ModelMetrics> metrics_;
+
+  /**
+   * @brief gauges sampled on export
+   */
+  std::vector<Gauge> gauges_;
+
+  /**
+   * @brief mutex guarding all metrics
+   */
+  mutable std::mutex mutex_;
+};
+
+
+}  // namespace tensorflow_cpp
@@ -27,6 +27,13 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -34,9 +41,19 @@ SOFTWARE.
 #include <vector>
 
 #include <tensorflow/core/platform/env.h>
+#include <tensorflow/core/framework/tensor_util.h>
 #include <tensorflow/core/public/session.h>
+#include <tensorflow/core/util/batch_util.h>
+#include <tensorflow_cpp/device_utils.h>
+#include <tensorflow_cpp/graph_optimization.h>
 #include <tensorflow_cpp/graph_utils.h>
+#include <tensorflow_cpp/input_validation.h>
+#include <tensorflow_cpp/observer.h>
+#include <tensorflow_cpp/preprocessing.h>
+#include <tensorflow_cpp/profiling.h>
 #include <tensorflow_cpp/saved_model_utils.h>
+#include <tensorflow_cpp/tensorrt_utils.h>
+#include <tensorflow_cpp/thread_pool.h>
 #include <tensorflow_cpp/utils.h>
 
 /**
@@ -45,8 +62,191 @@ SOFTWARE.
 namespace tensorflow_cpp {
 
 
+/**
+ * @brief Precompiled handle for running a model with fixed inputs/outputs.
+ *
+ * Created by `Model::makeCallable`. Running a callable skips the per-call
+ * feed/fetch signature lookup that `session->Run` has to perform.
+ */
+struct Callable {
+
+  /**
+   * @brief underlying TensorFlow callable handle
+   */
+  tf::Session::CallableHandle handle = 0;
+
+  /**
+   * @brief whether the handle has been created
+   */
+  bool is_valid = false;
+
+  /**
+   * @brief (layer) names of callable inputs, in feed order
+   */
+  std::vector<std::string> input_names;
+
+  /**
+   * @brief (layer) names of callable outputs, in fetch order
+   */
+  std::vector<std::string> output_names;
+
+  /**
+   * @brief node names of callable inputs, in feed order
+   */
+  std::vector<std::string> input_nodes;
+
+  /**
+   * @brief node names of callable outputs, in fetch order
+   */
+  std::vector<std::string> output_nodes;
+
+  /**
+   * @brief device where (device-resident) inputs reside (empty: host)
+   */
+  std::string input_device;
+
+  /**
+   * @brief device where (device-resident) outputs stay (empty: host)
+   */
+  std::string output_device;
+
+  /**
+   * @brief datatypes and shapes of callable inputs, in feed order, see
+   * `SessionConfig::input_validation`
+   */
+  std::vector<InputSpec> input_specs;
+};
+
+
+/**
+ * @brief Inputs/outputs of a SavedModel signature, resolved on load.
+ *
+ * Obtained via `Model::signature`. Input/output names are sorted as described
+ * in `getSavedModelInputNames`.
+ */
+struct Signature {
+
+  /**
+   * @brief signature name, e.g. "serving_default"
+   */
+  std::string name;
+
+  /**
+   * @brief layer names of signature inputs
+   */
+  std::vector<std::string> input_names;
+
+  /**
+   * @brief layer names of signature outputs
+   */
+  std::vector<std::string> output_names;
+
+  /**
+   * @brief node names of signature inputs
+   */
+  std::vector<std::string> input_nodes;
+
+  /**
+   * @brief node names of signature outputs
+   */
+  std::vector<std::string> output_nodes;
+
+  /**
+   * @brief shapes of signature inputs
+   */
+  std::vector<std::vector<int>> input_shapes;
+
+  /**
+   * @brief shapes of signature outputs
+   */
+  std::vector<std::vector<int>> output_shapes;
+
+  /**
+   * @brief datatypes of signature inputs
+   */
+  std::vector<tf::DataType> input_types;
+
+  /**
+   * @brief datatypes of signature outputs
+   */
+  std::vector<tf::DataType> output_types;
+
+  /**
+   * @brief mapping from layer names to node names
+   */
+  std::unordered_map<std::string, std::string> layer2node;
+
+  /**
+   * @brief precompiled callable for all inputs/outputs (invalid if it could
+   * not be created)
+   */
+  Callable callable;
+};
+
+
+/**
+ * @brief Callback invoked on completion of `Model::runAsync`.
+ *
+ * Receives the output tensors and, if the model failed to run, the
+ * corresponding exception.
+ */
+using AsyncCallback =
+  std::function<void(std::vector<tf::Tensor>&&, std::exception_ptr)>;
+
+
+/**
+ * @brief Inputs to run through a model after loading.
+ *
+ * Running all input shapes expected at inference time once ahead of time
+ * triggers graph specialization, kernel autotuning and allocator growth before
+ * the first actual inference call.
+ */
+struct WarmupProfile {
+
+  /**
+   * @brief batch sizes to run zero-filled inputs with, see
+   * `Model::makeDummyInputs`
+   */
+  std::vector<int> batch_sizes = {1};
+
+  /**
+   * @brief concrete shapes of all model inputs to run zero-filled inputs with,
+   * one shape per input for each run
+   */
+  std::vector<std::vector<std::vector<int>>> input_shapes;
+
+  /**
+   * @brief representative inputs, e.g. loaded from files, one tensor per input
+   * for each run
+   */
+  std::vector<std::vector<tf::Tensor>> inputs;
+
+  /**
+   * @brief number of times to run each warmup input
+   */
+  int n_runs = 1;
+
+  /**
+   * @brief number of threads to run warmup inputs on in parallel
+   */
+  int n_threads = 1;
+
+  /**
+   * @brief whether to also run SavedModel warmup requests from
+   * `assets.extra/tf_serving_warmup_requests`, if present
+   */
+  bool use_saved_model_warmup_requests = true;
+};
+
+
 /**
  * @brief Wrapper class for running TensorFlow SavedModels or FrozenGraphs.
+ *
+ * Once loaded, all const methods running the model (`operator()`, `run`) may
+ * be called concurrently from multiple threads, since the underlying session
+ * is thread-safe. Loading a model and the non-const getters are not
+ * thread-safe. See `ConcurrentModel` for a wrapper tailored to multi-threaded
+ * inference.
  */
 class Model {
 
@@ -65,14 +265,45 @@ class Model {
    * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
    * @param[in]  visible_device_list              list of GPUs to use, e.g.
    * "0,1"
+   * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+   * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
    */
   Model(const std::string& model_path, const bool warmup = false,
         const bool allow_growth = true,
         const double per_process_gpu_memory_fraction = 0,
-        const std::string& visible_device_list = "") {
+        const std::string& visible_device_list = "",
+        const int intra_op_parallelism_threads = 0,
+        const int inter_op_parallelism_threads = 0) {
 
     loadModel(model_path, warmup, allow_growth, per_process_gpu_memory_fraction,
-              visible_device_list);
+              visible_device_list, intra_op_parallelism_threads,
+              inter_op_parallelism_threads);
+  }
+
+  /**
+   * @brief Creates a model by loading it from disk.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  warmup      run dummy inference to warmup
+   */
+  Model(const std::string& model_path, const SessionConfig& config,
+        const bool warmup = false) {
+
+    loadModel(model_path, config, warmup);
+  }
+
+  /**
+   * @brief Creates a model by loading it from disk and warming it up.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  profile     warmup profile
+   */
+  Model(const std::string& model_path, const SessionConfig& config,
+        const WarmupProfile& profile) {
+
+    loadModel(model_path, config, profile);
   }
 
   /**
@@ -87,37 +318,120 @@ class Model {
    * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
    * @param[in]  visible_device_list              list of GPUs to use, e.g.
    * "0,1"
+   * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+   * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
    */
   void loadModel(const std::string& model_path, const bool warmup = false,
                  const bool allow_growth = true,
                  const double per_process_gpu_memory_fraction = 0,
-                 const std::string& visible_device_list = "") {
+                 const std::string& visible_device_list = "",
+                 const int intra_op_parallelism_threads = 0,
+                 const int inter_op_parallelism_threads = 0) {
+
+    loadModel(model_path,
+              makeSessionConfig(allow_growth, per_process_gpu_memory_fraction,
+                                visible_device_list,
+                                intra_op_parallelism_threads,
+                                inter_op_parallelism_threads),
+              warmup);
+  }
 
-    is_frozen_graph_ = (model_path.substr(model_path.size() - 3) == ".pb");
-    is_saved_model_ = !is_frozen_graph_;
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk.
+   *
+   * After the model has loaded, it's also run once with dummy inputs in order
+   * to speed-up the first actual inference call.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  warmup      run dummy inference to warmup
+   */
+  void loadModel(const std::string& model_path, const SessionConfig& config,
+                 const bool warmup = false) {
 
-    // load model
-    if (is_frozen_graph_) {
-      graph_def_ = loadFrozenGraph(model_path);
-      session_ = createSession(allow_growth, per_process_gpu_memory_fraction,
-                               visible_device_list);
+    is_loaded_ = false;
+    is_frozen_graph_ = (model_path.substr(model_path.size() - 3) == ".pb") ||
+                       config.memmapped_graph;
+    is_saved_model_ = !is_frozen_graph_;
+    if (is_frozen_graph_ && config.backend == Backend::kTensorRT)
+      throw std::runtime_error(
+        "TensorRT backend is only supported for SavedModels");
+    model_path_ = model_path;
+    session_config_ = config;
+    if (config.observer) observer_ = config.observer;
+
+    // load model, freeing a previously loaded FrozenGraph session first
+    session_ = nullptr;
+    frozen_graph_session_.reset();
+    if (is_frozen_graph_ && config.memmapped_graph) {
+      memmapped_env_.reset(new tf::MemmappedEnv(tf::Env::Default()));
+      graph_def_ = loadMemmappedFrozenGraph(model_path, memmapped_env_.get());
+      if (!config.device.empty())
+        placeGraphOnDevice(&graph_def_, config.device);
+      frozen_graph_session_.reset(
+        createSession(config, memmapped_env_.get()));
+      session_ = frozen_graph_session_.get();
+      loadGraphIntoSession(session_, graph_def_);
+    } else if (is_frozen_graph_) {
+      graph_def_ = config.optimize_graph
+                     ? loadOptimizedFrozenGraph(
+                         model_path, config.optimized_graph_cache_dir)
+                     : loadFrozenGraph(model_path);
+      if (!config.device.empty())
+        placeGraphOnDevice(&graph_def_, config.device);
+      frozen_graph_session_.reset(createSession(config));
+      session_ = frozen_graph_session_.get();
       loadGraphIntoSession(session_, graph_def_);
     } else {
-      saved_model_ =
-        loadSavedModel(model_path, allow_growth,
-                       per_process_gpu_memory_fraction, visible_device_list);
+      saved_model_ = (config.backend == Backend::kTensorRT)
+                       ? loadSavedModelWithTensorRT(model_path, config)
+                       : loadSavedModel(model_path, config);
       session_ = saved_model_.GetSession();
     }
 
     // automatically find inputs and outputs
     if (is_frozen_graph_) {
-      input_names_ = getGraphInputNames(graph_def_);
-      output_names_ = getGraphOutputNames(graph_def_);
+      graph_index_ = GraphIndex(graph_def_);
+      input_names_ = graph_index_.inputNames();
+      output_names_ = graph_index_.outputNames();
+      input_nodes_ = input_names_;
+      output_nodes_ = output_names_;
+      input_shapes_.clear();
+      input_types_.clear();
+      output_shapes_.clear();
+      output_types_.clear();
+      for (const auto& name : input_names_) {
+        input_shapes_.push_back(graph_index_.nodeShape(name));
+        input_types_.push_back(graph_index_.nodeType(name));
+      }
+      for (const auto& name : output_names_) {
+        output_shapes_.push_back(graph_index_.nodeShape(name));
+        output_types_.push_back(graph_index_.nodeType(name));
+      }
     } else {
-      input_names_ = getSavedModelInputNames(saved_model_, true);
-      output_names_ = getSavedModelOutputNames(saved_model_, true);
-      const auto input_nodes_ = getSavedModelInputNames(saved_model_, false);
-      const auto output_nodes_ = getSavedModelOutputNames(saved_model_, false);
+      graph_index_ = GraphIndex();
+      signatures_.clear();
+      for (const auto& signature_def : saved_model_.GetSignatures()) {
+        // skip internal signatures, e.g. __saved_model_init_op
+        if (signature_def.first.rfind("__", 0) == 0) continue;
+        signatures_[signature_def.first] =
+          makeSignature(saved_model_, signature_def.first);
+      }
+      if (signatures_.empty())
+        throw std::runtime_error("SavedModel has no signatures");
+      const auto default_signature = signatures_.count("serving_default") > 0
+                                       ? signatures_.find("serving_default")
+                                       : signatures_.begin();
+      input_names_ = default_signature->second.input_names;
+      output_names_ = default_signature->second.output_names;
+      input_nodes_ = default_signature->second.input_nodes;
+      output_nodes_ = default_signature->second.output_nodes;
+      input_shapes_ = default_signature->second.input_shapes;
+      input_types_ = default_signature->second.input_types;
+      output_shapes_ = default_signature->second.output_shapes;
+      output_types_ = default_signature->second.output_types;
+      saved_model_node2layer_.clear();
+      saved_model_layer2node_.clear();
       for (int k = 0; k < input_names_.size(); k++) {
         saved_model_node2layer_[input_nodes_[k]] = input_names_[k];
         saved_model_layer2node_[input_names_[k]] = input_nodes_[k];
@@ -129,9 +443,175 @@ class Model {
     }
     n_inputs_ = input_names_.size();
     n_outputs_ = output_names_.size();
+    node_shapes_.clear();
+    node_types_.clear();
+    for (int k = 0; k < n_inputs_; k++) {
+      node_shapes_[input_names_[k]] = input_shapes_[k];
+      node_types_[input_names_[k]] = input_types_[k];
+    }
+    for (int k = 0; k < n_outputs_; k++) {
+      node_shapes_[output_names_[k]] = output_shapes_[k];
+      node_types_[output_names_[k]] = output_types_[k];
+    }
+    input_specs_.resize(n_inputs_);
+    for (int k = 0; k < n_inputs_; k++)
+      input_specs_[k] = {input_names_[k], input_types_[k], input_shapes_[k]};
+    info_string_ = is_saved_model_ ? getSavedModelInfoString(saved_model_)
+                                   : getGraphInfoString(graph_index_);
+    if (is_frozen_graph_ && !config.keep_graph_def) releaseGraphDef();
+
+    // precompile default inputs/outputs and all signatures, fall back to
+    // session->Run() on failure
+    try {
+      default_callable_ = makeCallable(input_names_, output_names_);
+    } catch (const std::runtime_error&) {
+      default_callable_ = Callable();
+    }
+    for (auto& signature : signatures_) {
+      Signature& sig = signature.second;
+      try {
+        sig.callable =
+          makeNodeCallable(sig.input_names, sig.output_names, sig.input_nodes,
+                           sig.output_nodes, {}, {});
+        sig.callable.input_specs = signatureInputSpecs(sig);
+      } catch (const std::runtime_error&) {
+        sig.callable = Callable();
+      }
+    }
+
+    // reserve the GPU memory arena before the first inference
+    if (config.preallocate_gpu_memory) {
+      const std::string device = memoryDevice();
+      if (device.find("GPU") != std::string::npos)
+        reserveSessionDeviceMemory(session_, device);
+    }
 
     // run dummy inference to warm-up
     if (warmup) dummyCall();
+    is_loaded_ = true;
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk and warms it up.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  profile     warmup profile, see `warmup`
+   */
+  void loadModel(const std::string& model_path, const SessionConfig& config,
+                 const WarmupProfile& profile) {
+
+    // only report the model as loaded once it is warmed up
+    loadModel(model_path, config, false);
+    is_loaded_ = false;
+    warmup(profile);
+    is_loaded_ = true;
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk in the
+   * background.
+   *
+   * The model is loaded on the model's async thread pool, see
+   * `setAsyncThreads`. The model must neither be used, moved nor destroyed
+   * before loading has finished. Errors are passed on as exceptions through
+   * the future.
+   *
+   * @param[in]  model_path         SavedModel or FrozenGraph path
+   * @param[in]  config             session configuration
+   * @param[in]  warmup             run dummy inference to warmup
+   *
+   * @return  std::future<void>    completion of loading
+   */
+  std::future<void> loadAsync(const std::string& model_path,
+                              const SessionConfig& config = SessionConfig(),
+                              const bool warmup = false) {
+
+    return async_pool_->submit([this, model_path, config, warmup]() {
+      loadModel(model_path, config, warmup);
+    });
+  }
+
+  /**
+   * @brief Loads a SavedModel or FrozenGraph model from disk in the
+   * background and invokes a callback on completion.
+   *
+   * See `loadAsync`. The callback is invoked on a thread of the model's async
+   * thread pool with the exception, if the model failed to load.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  warmup      run dummy inference to warmup
+   * @param[in]  callback    completion callback
+   */
+  void loadAsync(const std::string& model_path, const SessionConfig& config,
+                 const bool warmup,
+                 const std::function<void(std::exception_ptr)>& callback) {
+
+    async_pool_->schedule([this, model_path, config, warmup, callback]() {
+      std::exception_ptr error;
+      try {
+        loadModel(model_path, config, warmup);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      callback(error);
+    });
+  }
+
+  /**
+   * @brief Warms up the model by running all inputs of a warmup profile.
+   *
+   * Runs zero-filled inputs for each batch size and each set of input shapes,
+   * the representative inputs and, for SavedModels, the stored warmup
+   * requests. Each input is run `profile.n_runs` times, distributed over
+   * `profile.n_threads` threads.
+   *
+   * @param[in]  profile  warmup profile
+   */
+  void warmup(const WarmupProfile& profile) {
+
+    // collect warmup inputs
+    std::vector<std::vector<tf::Tensor>> warmup_inputs;
+    for (const int batch_size : profile.batch_sizes)
+      warmup_inputs.push_back(makeDummyInputs(batch_size));
+    const auto input_types = getInputTypes();
+    for (const auto& shapes : profile.input_shapes) {
+      if (shapes.size() != n_inputs_)
+        throw std::runtime_error("Warmup profile specifies " +
+                                 std::to_string(shapes.size()) +
+                                 " input shapes, but model has " +
+                                 std::to_string(n_inputs_) + " inputs");
+      std::vector<tf::Tensor> inputs;
+      for (int k = 0; k < n_inputs_; k++) {
+        std::vector<long int> shape(shapes[k].begin(), shapes[k].end());
+        inputs.push_back(makeZeroTensor(
+          input_types[k],
+          tf::TensorShape(tf::gtl::ArraySlice<long int>(shape))));
+      }
+      warmup_inputs.push_back(inputs);
+    }
+    warmup_inputs.insert(warmup_inputs.end(), profile.inputs.begin(),
+                         profile.inputs.end());
+    std::vector<std::vector<std::pair<std::string, tf::Tensor>>>
+      warmup_requests;
+    if (is_saved_model_ && profile.use_saved_model_warmup_requests)
+      warmup_requests = loadSavedModelWarmupRequests(model_path_);
+
+    // run warmup inputs, rethrowing the first failure
+    ThreadPool pool(std::max(profile.n_threads, 1));
+    std::vector<std::future<void>> runs;
+    for (int r = 0; r < profile.n_runs; r++) {
+      for (const auto& inputs : warmup_inputs)
+        runs.push_back(pool.submit([this, &inputs]() {
+          volatile auto outputs = (*this)(inputs);
+        }));
+      for (const auto& request : warmup_requests)
+        runs.push_back(pool.submit([this, &request]() {
+          volatile auto outputs = (*this)(request, output_names_);
+        }));
+    }
+    for (auto& run : runs) run.get();
   }
 
   /**
@@ -141,10 +621,7 @@ class Model {
    * @return  false  if model is not loaded
    */
   bool isLoaded() const {
-
-    bool is_loaded = bool(session_);
-
-    return is_loaded;
+    return is_loaded_;
   }
 
   /**
@@ -162,41 +639,101 @@ class Model {
    */
   std::unordered_map<std::string, tf::Tensor> operator()(
     const std::vector<std::pair<std::string, tf::Tensor>>& inputs,
-    const std::vector<std::string>& output_names) const{
+    const std::vector<std::string>& output_names) const {
+
+    return (*this)(std::vector<std::pair<std::string, tf::Tensor>>(inputs),
+                   output_names);
+  }
+
+  /**
+   * @brief Runs the model, taking ownership of the inputs.
+   *
+   * See `operator()(const std::vector<std::pair<std::string, tf::Tensor>>&,
+   * const std::vector<std::string>&)`. The input vector is reused to feed
+   * the session, so no tensors or names are copied.
+   *
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    std::vector<std::pair<std::string, tf::Tensor>>&& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    ProfilingScope profiling(profiler_.get());
+    prepareInputs(inputs);
 
     // properly set input/output names for session->Run()
-    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
     std::vector<std::string> output_node_names;
     if (is_saved_model_) {
-      for (const auto& input : inputs)
-        input_nodes.push_back(
-          {saved_model_layer2node_.find(input.first)->second, input.second});
+      for (auto& input : inputs)
+        input.first = saved_model_layer2node_.find(input.first)->second;
+      output_node_names.reserve(output_names.size());
       for (const auto& name : output_names)
         output_node_names.push_back(saved_model_layer2node_.find(name)->second);
     } else if (is_frozen_graph_) {
-      input_nodes = inputs;
       output_node_names = output_names;
     } else {
       return {};
     }
 
     // run model
-    tf::Status status;
     std::vector<tf::Tensor> output_tensors;
-    status = session_->Run(input_nodes, output_node_names, {}, &output_tensors);
+    tf::Status status =
+      runSession(inputs, output_node_names, &output_tensors, profiling);
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
 
     // build outputs
     std::unordered_map<std::string, tf::Tensor> outputs;
-    if (status.ok()) {
-      for (int k = 0; k < output_tensors.size(); k++)
-        outputs[output_names[k]] = output_tensors[k];
-    } else {
-      throw std::runtime_error("Failed to run model: " + status.ToString());
-    }
+    outputs.reserve(output_tensors.size());
+    for (int k = 0; k < output_tensors.size(); k++)
+      outputs.emplace(output_names[k], std::move(output_tensors[k]));
 
     return outputs;
   }
 
+  /**
+   * @brief Runs the model.
+   *
+   * Inputs/outputs are specified by their index, as resolved once via
+   * `inputIndex` and `outputIndex`. This avoids the per-call name lookups of
+   * the name-based `operator()`.
+   *
+   * @param[in]  inputs                   input tensors by input index
+   * @param[in]  output_indices           output indices
+   *
+   * @return  std::vector<tf::Tensor>     output tensors, in order of indices
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<std::pair<int, tf::Tensor>>& inputs,
+    const std::vector<int>& output_indices) const {
+
+    ProfilingScope profiling(profiler_.get());
+
+    // properly set input/output names for session->Run()
+    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+    std::vector<std::string> output_node_names;
+    input_nodes.reserve(inputs.size());
+    output_node_names.reserve(output_indices.size());
+    for (const auto& input : inputs) {
+      input_nodes.emplace_back(input_nodes_.at(input.first), input.second);
+      prepareInput(input.first, input_nodes.back().second);
+    }
+    for (const int idx : output_indices)
+      output_node_names.push_back(output_nodes_.at(idx));
+
+    // run model
+    std::vector<tf::Tensor> output_tensors;
+    tf::Status status =
+      runSession(input_nodes, output_node_names, &output_tensors, profiling);
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
+
+    return output_tensors;
+  }
+
   /**
    * @brief Runs the model.
    *
@@ -216,19 +753,25 @@ class Model {
         std::to_string(n_inputs_) + " inputs and " +
         std::to_string(n_outputs_) + " outputs.");
     }
+    if (!checkInput(0, input_tensor))
+      return std::move((*this)(std::vector<tf::Tensor>{input_tensor})[0]);
 
     // run model
-    auto outputs =
-      (*this)({{input_names_[0], input_tensor}}, {output_names_[0]});
+    if (isMicroBatched({input_tensor}))
+      return runMicroBatched({input_tensor})[0];
+    if (default_callable_.is_valid)
+      return std::move(runCallable(default_callable_, {input_tensor})[0]);
 
-    return outputs[output_names_[0]];
+    return std::move(runDefault({{input_nodes_[0], input_tensor}})[0]);
   }
 
   /**
    * @brief Runs the model.
    *
    * This version of `operator()` works without having to specify input/output
-   * names of the model, but is limited to FrozenGraph models.
+   * names of the model. Input tensors are expected in the order given by
+   * `inputNames`, output tensors are returned in the order given by
+   * `outputNames`.
    *
    * @param[in]  input_tensors            input tensors
    *
@@ -237,384 +780,1718 @@ class Model {
   std::vector<tf::Tensor> operator()(
     const std::vector<tf::Tensor>& input_tensors) const {
 
-    if (input_tensors.size() != n_inputs_) {
-      throw std::runtime_error(
-        "Model has " + std::to_string(n_inputs_) + " inputs, but " +
-        std::to_string(input_tensors.size()) + " input tensors were given");
-    }
+    checkNumInputs(input_tensors);
+    if (!checkInputs(input_tensors))
+      return (*this)(std::vector<tf::Tensor>(input_tensors));
+
+    // split oversized batches, see setMicroBatching
+    if (isMicroBatched(input_tensors)) return runMicroBatched(input_tensors);
+
+    // run precompiled default callable, if available
+    if (default_callable_.is_valid)
+      return runCallable(default_callable_, input_tensors);
 
     // assign inputs in default order
-    std::vector<std::pair<std::string, tf::Tensor>> inputs;
+    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+    input_nodes.reserve(n_inputs_);
     for (int k = 0; k < n_inputs_; k++)
-      inputs.push_back({input_names_[k], input_tensors[k]});
+      input_nodes.emplace_back(input_nodes_[k], input_tensors[k]);
 
-    // run model
-    auto outputs = (*this)(inputs, output_names_);
+    return runDefault(input_nodes);
+  }
 
-    // return output tensors in default order
-    std::vector<tf::Tensor> output_tensors;
-    for (const auto& name : output_names_)
-      output_tensors.push_back(outputs[name]);
+  /**
+   * @brief Runs the model, taking ownership of the input tensors.
+   *
+   * See `operator()(const std::vector<tf::Tensor>&)`. Input tensors are
+   * moved into the session feeds instead of being copied.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    std::vector<tf::Tensor>&& input_tensors) const {
 
-    return output_tensors;
+    checkNumInputs(input_tensors);
+    prepareInputs(input_tensors);
+    if (isMicroBatched(input_tensors)) return runMicroBatched(input_tensors);
+    if (default_callable_.is_valid)
+      return runCallable(default_callable_, input_tensors);
+
+    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+    input_nodes.reserve(n_inputs_);
+    for (int k = 0; k < n_inputs_; k++)
+      input_nodes.emplace_back(input_nodes_[k], std::move(input_tensors[k]));
+
+    return runDefault(input_nodes);
   }
 
   /**
-   * @brief Determines the shape of a model node.
+   * @brief Runs the model using a precompiled callable.
    *
-   * @param[in]  name              node name
+   * Input tensors are expected in the input order used to create the
+   * callable, output tensors are returned in its output order.
    *
-   * @return  std::vector<int>     node shape
+   * @param[in]  callable                 callable created by `makeCallable`
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
    */
-  std::vector<int> getNodeShape(const std::string& name) {
+  std::vector<tf::Tensor> operator()(
+    const Callable& callable,
+    const std::vector<tf::Tensor>& input_tensors) const {
 
-    if (is_saved_model_) {
-      return getSavedModelNodeShape(saved_model_,
-                                    saved_model_layer2node_[name]);
-    } else if (is_frozen_graph_) {
-      return getGraphNodeShape(graph_def_, name);
-    } else {
-      return {};
-    }
+    std::vector<tf::Tensor> output_tensors;
+    run(callable, input_tensors, output_tensors);
+
+    return output_tensors;
   }
 
   /**
-   * @brief Determines the shape of the model input.
+   * @brief Runs the model using a precompiled callable, writing into a
+   * caller-provided output vector.
    *
-   * This function works without having to specify input/output names of the
-   * model, but is limited to single-input/single-output models.
+   * Input tensors are expected in the input order used to create the
+   * callable. The output vector is overwritten with the output tensors in the
+   * callable's output order. Reusing the same output vector across calls
+   * avoids any heap allocations by the wrapper after the first call. Inputs
+   * are validated as configured by `SessionConfig::input_validation`;
+   * device-resident inputs are only checked, not converted.
    *
-   * @return  std::vector<int>  node shape
+   * @param[in]   callable        callable created by `makeCallable`
+   * @param[in]   input_tensors   input tensors
+   * @param[out]  output_tensors  output tensors
    */
-  std::vector<int> getInputShape() {
+  void run(const Callable& callable,
+           const std::vector<tf::Tensor>& input_tensors,
+           std::vector<tf::Tensor>& output_tensors) const {
 
-    if (n_inputs_ != 1) {
+    if (!callable.is_valid)
+      throw std::runtime_error("Cannot run invalid callable");
+    if (input_tensors.size() != callable.input_names.size()) {
       throw std::runtime_error(
-        "std::vector<int> tensorflow_cpp::Model::getInputShape()' is only "
-        "available for single-input models. Found " +
-        std::to_string(n_inputs_) + " inputs.");
+        "Callable has " + std::to_string(callable.input_names.size()) +
+        " inputs, but " + std::to_string(input_tensors.size()) +
+        " input tensors were given");
     }
 
-    return getNodeShape(input_names_[0]);
+    // device-resident inputs can only be checked, not converted on the host
+    if (!checkInputs(callable.input_specs, input_tensors)) {
+      if (!callable.input_device.empty()) {
+        for (int k = 0; k < input_tensors.size(); k++)
+          validateInput(callable.input_specs[k], input_tensors[k]);
+      }
+      runCallable(callable, convertInputs(callable.input_specs, input_tensors),
+                  output_tensors);
+    } else {
+      runCallable(callable, input_tensors, output_tensors);
+    }
+  }
+
+  /**
+   * @brief Runs a SavedModel signature.
+   *
+   * Input tensors are expected in the order given by the signature's
+   * `input_names`, output tensors are returned in the order given by its
+   * `output_names`.
+   *
+   * @param[in]  signature                signature obtained via `signature`
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const Signature& signature,
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    if (signature.callable.is_valid)
+      return (*this)(signature.callable, input_tensors);
+
+    if (input_tensors.size() != signature.input_nodes.size()) {
+      throw std::runtime_error(
+        "Signature '" + signature.name + "' has " +
+        std::to_string(signature.input_nodes.size()) + " inputs, but " +
+        std::to_string(input_tensors.size()) + " input tensors were given");
+    }
+    const std::vector<InputSpec> specs = signatureInputSpecs(signature);
+    const std::vector<tf::Tensor> prepared =
+      checkInputs(specs, input_tensors) ? input_tensors
+                                        : convertInputs(specs, input_tensors);
+    ProfilingScope profiling(profiler_.get());
+    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+    for (int k = 0; k < prepared.size(); k++)
+      input_nodes.emplace_back(signature.input_nodes[k], prepared[k]);
+    std::vector<tf::Tensor> output_tensors;
+    tf::Status status = runSession(input_nodes, signature.output_nodes,
+                                   &output_tensors, profiling);
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
+
+    return output_tensors;
+  }
+
+  /**
+   * @brief Runs a SavedModel signature selected by name.
+   *
+   * See `operator()(const Signature&, const std::vector<tf::Tensor>&)`.
+   *
+   * @param[in]  signature_name           signature name
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::string& signature_name,
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    return (*this)(signature(signature_name), input_tensors);
+  }
+
+  /**
+   * @brief Runs a SavedModel signature selected by name, with inputs/outputs
+   * given by layer name.
+   *
+   * @param[in]  signature_name                               signature name
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    const std::string& signature_name,
+    const std::vector<std::pair<std::string, tf::Tensor>>& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    const Signature& sig = signature(signature_name);
+    auto getSignatureNode = [&sig](const std::string& name) {
+      const auto it = sig.layer2node.find(name);
+      if (it == sig.layer2node.end())
+        throw std::runtime_error("Unknown input/output '" + name +
+                                 "' of signature '" + sig.name + "'");
+      return it->second;
+    };
+
+    ProfilingScope profiling(profiler_.get());
+    std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+    std::vector<std::string> output_node_names;
+    for (const auto& input : inputs) {
+      tf::Tensor tensor = input.second;
+      const auto it =
+        std::find(sig.input_names.begin(), sig.input_names.end(), input.first);
+      if (it != sig.input_names.end()) {
+        const int k = it - sig.input_names.begin();
+        const InputSpec spec = {input.first, sig.input_types[k],
+                                sig.input_shapes[k]};
+        if (!checkInput(spec, tensor)) tensor = convertInput(spec, tensor);
+      }
+      input_nodes.emplace_back(getSignatureNode(input.first), tensor);
+    }
+    for (const auto& name : output_names)
+      output_node_names.push_back(getSignatureNode(name));
+    std::vector<tf::Tensor> output_tensors;
+    tf::Status status =
+      runSession(input_nodes, output_node_names, &output_tensors, profiling);
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
+
+    std::unordered_map<std::string, tf::Tensor> outputs;
+    for (int k = 0; k < output_tensors.size(); k++)
+      outputs[output_names[k]] = output_tensors[k];
+
+    return outputs;
+  }
+
+  /**
+   * @brief Runs the model, writing into a caller-provided output vector.
+   *
+   * Input tensors are expected in the order given by `inputNames`, output
+   * tensors are written in the order given by `outputNames`. Reusing the same
+   * output vector across calls avoids any heap allocations by the wrapper
+   * after the first call, as long as the default callable is available.
+   *
+   * @param[in]   input_tensors   input tensors
+   * @param[out]  output_tensors  output tensors
+   */
+  void run(const std::vector<tf::Tensor>& input_tensors,
+           std::vector<tf::Tensor>& output_tensors) const {
+
+    if (!checkInputs(input_tensors)) {
+      output_tensors = (*this)(std::vector<tf::Tensor>(input_tensors));
+    } else if (isMicroBatched(input_tensors)) {
+      output_tensors = runMicroBatched(input_tensors);
+    } else if (default_callable_.is_valid) {
+      runCallable(default_callable_, input_tensors, output_tensors);
+    } else {
+      output_tensors = (*this)(input_tensors);
+    }
+  }
+
+  /**
+   * @brief Runs the model asynchronously.
+   *
+   * The model is run on the model's async thread pool, see `setAsyncThreads`.
+   * Input tensors are expected in the order given by `inputNames`, output
+   * tensors are returned in the order given by `outputNames`. Errors are
+   * passed on as exceptions through the future.
+   *
+   * The model must not be moved or destroyed while calls are pending.
+   *
+   * @param[in]  input_tensors                     input tensors
+   *
+   * @return  std::future<std::vector<tf::Tensor>> output tensors
+   */
+  std::future<std::vector<tf::Tensor>> runAsync(
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    return async_pool_->submit(
+      [this, input_tensors]() { return (*this)(input_tensors); });
+  }
+
+  /**
+   * @brief Runs the model asynchronously using a precompiled callable.
+   *
+   * See `runAsync`. The callable must stay valid while the call is pending.
+   *
+   * @param[in]  callable                          callable created by
+   * `makeCallable`
+   * @param[in]  input_tensors                     input tensors
+   *
+   * @return  std::future<std::vector<tf::Tensor>> output tensors
+   */
+  std::future<std::vector<tf::Tensor>> runAsync(
+    const Callable& callable,
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    return async_pool_->submit([this, callable, input_tensors]() {
+      return (*this)(callable, input_tensors);
+    });
+  }
+
+  /**
+   * @brief Runs the model asynchronously and invokes a callback on completion.
+   *
+   * See `runAsync`. The callback is invoked on a thread of the model's async
+   * thread pool with the output tensors and, if the model failed to run, the
+   * corresponding exception.
+   *
+   * @param[in]  input_tensors  input tensors
+   * @param[in]  callback       completion callback
+   */
+  void runAsync(const std::vector<tf::Tensor>& input_tensors,
+                const AsyncCallback& callback) const {
+
+    async_pool_->schedule([this, input_tensors, callback]() {
+      std::vector<tf::Tensor> output_tensors;
+      std::exception_ptr error;
+      try {
+        run(input_tensors, output_tensors);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      callback(std::move(output_tensors), error);
+    });
+  }
+
+  /**
+   * @brief Sets the number of threads used for asynchronous runs.
+   *
+   * Defaults to a single dedicated thread, which preserves the order of calls.
+   * Must not be called while asynchronous calls are pending.
+   *
+   * @param[in]  n_threads  number of threads (0: number of cores)
+   */
+  void setAsyncThreads(const int n_threads) {
+    async_pool_.reset(new ThreadPool(n_threads));
+  }
+
+  /**
+   * @brief Returns the number of asynchronous calls waiting for a thread.
+   *
+   * @return  int  number of queued calls
+   */
+  int asyncQueueSize() const {
+    return async_pool_->queueSize();
+  }
+
+  /**
+   * @brief Enables splitting of oversized batches into micro-batches.
+   *
+   * Applies to the positional `operator()` and `run`. Inputs whose batch
+   * dimension exceeds `micro_batch_size` are split accordingly, the
+   * micro-batches are run on up to `n_parallel` threads and their outputs are
+   * copied into preallocated output tensors. At most `n_parallel`
+   * micro-batches are in flight at a time, bounding peak memory. All inputs
+   * and outputs are expected to have the batch dimension first.
+   *
+   * Must not be called while the model is running.
+   *
+   * @param[in]  micro_batch_size  maximum micro-batch size (0: disabled)
+   * @param[in]  n_parallel        number of micro-batches run concurrently
+   */
+  void setMicroBatching(const int micro_batch_size, const int n_parallel = 1) {
+
+    micro_batch_size_ = std::max(micro_batch_size, 0);
+    micro_batch_pool_.reset(n_parallel > 1 ? new ThreadPool(n_parallel)
+                                           : nullptr);
+  }
+
+  /**
+   * @brief Returns the maximum micro-batch size, see `setMicroBatching`.
+   *
+   * @return  int  maximum micro-batch size (0: disabled)
+   */
+  int microBatchSize() const {
+    return micro_batch_size_;
+  }
+
+  /**
+   * @brief Precompiles a callable for a fixed set of inputs/outputs.
+   *
+   * The callable can be passed to `operator()` repeatedly, avoiding the
+   * per-call feed/fetch setup of `session->Run`. Input/output names follow the
+   * same conventions as for the name-based `operator()`.
+   *
+   * By default, input tensors are expected and output tensors are returned in
+   * host memory. If `input_device` is set, input tensors are expected to
+   * reside in that device's memory already, e.g. as allocated by
+   * `allocateDeviceTensor` or as returned by another model's callable. If
+   * `output_device` is set, output tensors stay in that device's memory. This
+   * allows to chain models on the same GPU without copying through the host.
+   * Note that device-resident outputs are returned without waiting for the
+   * device to finish computing them, so they must only be consumed by
+   * operations on the same device.
+   *
+   * @param[in]  input_names    input names, defining the feed order
+   * @param[in]  output_names   output names, defining the fetch order
+   * @param[in]  input_device   full device name where inputs reside, e.g.
+   * from `gpuDeviceName` (empty: host)
+   * @param[in]  output_device  full device name where outputs should stay
+   * (empty: host)
+   *
+   * @return  Callable          callable
+   */
+  Callable makeCallable(const std::vector<std::string>& input_names,
+                        const std::vector<std::string>& output_names,
+                        const std::string& input_device = "",
+                        const std::string& output_device = "") const {
+
+    if (!session_)
+      throw std::runtime_error("Cannot make callable before loading a model");
+
+    std::vector<std::string> input_nodes;
+    std::vector<std::string> output_nodes;
+    for (const auto& name : input_names)
+      input_nodes.push_back(getNodeName(name));
+    for (const auto& name : output_names)
+      output_nodes.push_back(getNodeName(name));
+
+    return makeNodeCallable(
+      input_names, output_names, input_nodes, output_nodes,
+      std::vector<std::string>(input_names.size(), input_device),
+      std::vector<std::string>(output_names.size(), output_device));
+  }
+
+  /**
+   * @brief Precompiles a callable for a fixed set of inputs/outputs, with a
+   * device per input/output.
+   *
+   * See `makeCallable`. Allows to mix host and device-resident tensors, e.g.
+   * to keep only some inputs/outputs on the GPU.
+   *
+   * @param[in]  input_names     input names, defining the feed order
+   * @param[in]  output_names    output names, defining the fetch order
+   * @param[in]  input_devices   full device name per input (empty: host)
+   * @param[in]  output_devices  full device name per output (empty: host)
+   *
+   * @return  Callable           callable
+   */
+  Callable makeCallableOnDevices(
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::vector<std::string>& input_devices,
+    const std::vector<std::string>& output_devices) const {
+
+    if (!session_)
+      throw std::runtime_error("Cannot make callable before loading a model");
+    if (input_devices.size() != input_names.size() ||
+        output_devices.size() != output_names.size())
+      throw std::runtime_error(
+        "Number of devices does not match number of inputs/outputs");
+
+    std::vector<std::string> input_nodes;
+    std::vector<std::string> output_nodes;
+    for (const auto& name : input_names)
+      input_nodes.push_back(getNodeName(name));
+    for (const auto& name : output_names)
+      output_nodes.push_back(getNodeName(name));
+
+    return makeNodeCallable(input_names, output_names, input_nodes,
+                            output_nodes, input_devices, output_devices);
+  }
+
+  /**
+   * @brief Precompiles a callable for a fixed set of inputs/outputs.
+   *
+   * Inputs/outputs are specified by their index, see `inputIndex` and
+   * `outputIndex`.
+   *
+   * @param[in]  input_indices   input indices, defining the feed order
+   * @param[in]  output_indices  output indices, defining the fetch order
+   *
+   * @return  Callable           callable
+   */
+  Callable makeCallable(const std::vector<int>& input_indices,
+                        const std::vector<int>& output_indices) const {
+
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    for (const int idx : input_indices)
+      input_names.push_back(input_names_.at(idx));
+    for (const int idx : output_indices)
+      output_names.push_back(output_names_.at(idx));
+
+    return makeCallable(input_names, output_names);
+  }
+
+  /**
+   * @brief Releases the resources held by a callable.
+   *
+   * Callables that are not released explicitly are freed together with the
+   * session.
+   *
+   * @param[in,out]  callable  callable created by `makeCallable`
+   */
+  void releaseCallable(Callable& callable) const {
+
+    if (!callable.is_valid) return;
+    tf::Status status = session_->ReleaseCallable(callable.handle);
+    if (!status.ok())
+      throw std::runtime_error("Failed to release callable: " +
+                               status.ToString());
+    callable = Callable();
+  }
+
+  /**
+   * @brief Returns the precompiled callable for the default inputs/outputs.
+   *
+   * The callable runs all inputs/outputs in the order given by `inputNames`
+   * and `outputNames`. It is invalid if it could not be created on load.
+   *
+   * @return  const Callable&  default callable
+   */
+  const Callable& defaultCallable() const {
+    return default_callable_;
+  }
+
+  /**
+   * @brief Returns the names of all SavedModel signatures.
+   *
+   * @return  std::vector<std::string>  signature names (empty for FrozenGraphs)
+   */
+  std::vector<std::string> signatureNames() const {
+
+    std::vector<std::string> names;
+    for (const auto& signature : signatures_) names.push_back(signature.first);
+
+    return names;
+  }
+
+  /**
+   * @brief Returns a SavedModel signature with its resolved inputs/outputs.
+   *
+   * The default inputs/outputs (`inputNames`, `outputNames`) are those of
+   * "serving_default" or, if not present, of the first signature.
+   *
+   * @param[in]  name               signature name
+   *
+   * @return  const Signature&      signature
+   */
+  const Signature& signature(const std::string& name) const {
+
+    const auto it = signatures_.find(name);
+    if (it == signatures_.end())
+      throw std::runtime_error("Unknown SavedModel signature '" + name + "'");
+
+    return it->second;
+  }
+
+  /**
+   * @brief Sets an observer notified around every session run.
+   *
+   * The observer is shared, e.g. by all models reporting to the same metrics
+   * exporter. Must not be called while model calls are pending.
+   *
+   * @param[in]  observer  observer (nullptr: none)
+   */
+  void setObserver(std::shared_ptr<ModelObserver> observer) {
+    observer_ = std::move(observer);
+  }
+
+  /**
+   * @brief Returns the observer notified around every session run.
+   *
+   * @return  std::shared_ptr<ModelObserver>  observer, nullptr if none
+   */
+  std::shared_ptr<ModelObserver> observer() const {
+    return observer_;
+  }
+
+  /**
+   * @brief Sets the name the model is reported with to observers.
+   *
+   * @param[in]  name  model name (empty: model path)
+   */
+  void setName(const std::string& name) {
+    name_ = name;
+  }
+
+  /**
+   * @brief Returns the name the model is reported with to observers.
+   *
+   * @return  const std::string&  model name, defaults to the model path
+   */
+  const std::string& name() const {
+    return name_.empty() ? model_path_ : name_;
+  }
+
+  /**
+   * @brief Enables profiling of model calls.
+   *
+   * Records the wall time of every call, split into wrapper overhead, session
+   * run and output construction. Optionally, every n-th call is run with
+   * `tf::RunOptions::FULL_TRACE` to collect its step stats. Resets any
+   * previously collected statistics. Must not be called while model calls are
+   * pending.
+   *
+   * @param[in]  trace_every_n  collect a full trace every n-th call (0: never)
+   */
+  void enableProfiling(const int trace_every_n = 0) {
+    profiler_.reset(new Profiler(trace_every_n));
+  }
+
+  /**
+   * @brief Disables profiling of model calls.
+   *
+   * Must not be called while model calls are pending.
+   */
+  void disableProfiling() {
+    profiler_.reset();
+  }
+
+  /**
+   * @brief Returns whether profiling of model calls is enabled.
+   *
+   * @return  true   if profiling is enabled
+   * @return  false  if profiling is disabled
+   */
+  bool isProfiling() const {
+    return bool(profiler_);
+  }
+
+  /**
+   * @brief Returns the statistics collected since profiling was enabled.
+   *
+   * @return  ProfilingStats  statistics, empty if profiling is disabled
+   */
+  ProfilingStats profilingStats() const {
+    return profiler_ ? profiler_->stats() : ProfilingStats();
+  }
+
+  /**
+   * @brief Resets the statistics collected so far.
+   */
+  void resetProfilingStats() {
+    if (profiler_) profiler_->reset();
+  }
+
+  /**
+   * @brief Returns the step stats of the last traced call as Chrome trace.
+   *
+   * See `enableProfiling` and `stepStatsToChromeTrace`.
+   *
+   * @return  std::string  Chrome trace JSON
+   */
+  std::string getChromeTrace() const {
+    return stepStatsToChromeTrace(
+      profilingStats().last_run_metadata.step_stats());
+  }
+
+  /**
+   * @brief Determines the name of a GPU available to the model's session.
+   *
+   * @param[in]  gpu_index     index among the session's GPUs
+   *
+   * @return  std::string      full device name, empty if there is no such GPU
+   */
+  std::string gpuDeviceName(const int gpu_index = 0) const {
+    return getSessionGpuDeviceName(session_, gpu_index);
+  }
+
+  /**
+   * @brief Allocates a tensor in pinned (page-locked) host memory.
+   *
+   * Pinned input tensors are copied to the GPU faster and asynchronously.
+   * Falls back to regular host memory if the model's session has no GPU.
+   *
+   * @param[in]  dtype         datatype
+   * @param[in]  shape         shape
+   * @param[in]  device_name   GPU the memory is pinned for (empty: first GPU)
+   *
+   * @return  tf::Tensor       tensor
+   */
+  tf::Tensor allocatePinnedTensor(const tf::DataType dtype,
+                                  const tf::TensorShape& shape,
+                                  const std::string& device_name = "") const {
+
+    const std::string device =
+      device_name.empty() ? gpuDeviceName() : device_name;
+    if (device.empty()) return tf::Tensor(dtype, shape);
+
+    return tf::Tensor(getSessionDeviceAllocator(session_, device, true), dtype,
+                      shape);
+  }
+
+  /**
+   * @brief Allocates a tensor in device memory.
+   *
+   * Device tensors can be fed to callables created with a matching
+   * `input_device`, see `makeCallable`.
+   *
+   * @param[in]  dtype         datatype
+   * @param[in]  shape         shape
+   * @param[in]  device_name   device to allocate on (empty: first GPU)
+   *
+   * @return  tf::Tensor       tensor
+   */
+  tf::Tensor allocateDeviceTensor(const tf::DataType dtype,
+                                  const tf::TensorShape& shape,
+                                  const std::string& device_name = "") const {
+
+    const std::string device =
+      device_name.empty() ? gpuDeviceName() : device_name;
+    if (device.empty())
+      throw std::runtime_error("Cannot allocate device tensor without GPU");
+
+    return tf::Tensor(getSessionDeviceAllocator(session_, device), dtype,
+                      shape);
+  }
+
+  /**
+   * @brief Attaches a preprocessing stage to a model input.
+   *
+   * The datatype and rank of the input are determined once here. See
+   * `preprocess`.
+   *
+   * @param[in]  config       preprocessing configuration
+   * @param[in]  input_index  model input index, see `inputNames`
+   */
+  void setPreprocessing(const PreprocessingConfig& config,
+                        const int input_index = 0) {
+
+    if (input_index < 0 || input_index >= n_inputs_)
+      throw std::runtime_error("Invalid model input index " +
+                               std::to_string(input_index));
+    PreprocessingStage stage;
+    stage.config = config;
+    stage.dtype = getInputTypes()[input_index];
+    stage.rank = getInputShapes()[input_index].size();
+    preprocessing_[input_index] = stage;
+  }
+
+  /**
+   * @brief Creates an input tensor from an 8-bit HWC image in a single pass.
+   *
+   * Applies the preprocessing stage attached to the input via
+   * `setPreprocessing`. The tensor has the input's datatype and shape
+   * `[1, height, width, channels]` (or `[1, channels, height, width]`). For
+   * inputs of lower rank, a single channel dimension and then the batch
+   * dimension are dropped.
+   *
+   * @param[in]  image        HWC image
+   * @param[in]  height       image height
+   * @param[in]  width        image width
+   * @param[in]  channels     number of channels
+   * @param[in]  row_stride   bytes per image row (0: `width * channels`)
+   * @param[in]  input_index  model input index, see `inputNames`
+   *
+   * @return  tf::Tensor      input tensor
+   */
+  tf::Tensor preprocess(const uint8_t* image, const int height,
+                        const int width, const int channels,
+                        const int row_stride = 0,
+                        const int input_index = 0) const {
+
+    const auto it = preprocessing_.find(input_index);
+    if (it == preprocessing_.end())
+      throw std::runtime_error("No preprocessing attached to model input " +
+                               std::to_string(input_index));
+    const PreprocessingStage& stage = it->second;
+
+    std::vector<tf::int64> dims;
+    if (stage.config.channels_first)
+      dims = {1, channels, height, width};
+    else
+      dims = {1, height, width, channels};
+    if (stage.rank > 0 && stage.rank < dims.size() && channels == 1)
+      dims.erase(stage.config.channels_first ? dims.begin() + 1
+                                             : dims.end() - 1);
+    while (stage.rank > 0 && stage.rank < dims.size() && dims[0] == 1)
+      dims.erase(dims.begin());
+
+    tf::Tensor tensor(stage.dtype,
+                      tf::TensorShape(tf::gtl::ArraySlice<tf::int64>(dims)));
+    preprocessImage(image, height, width, channels, row_stride, stage.config,
+                    tensor);
+
+    return tensor;
+  }
+
+  /**
+   * @brief Determines the shape of a model node.
+   *
+   * @param[in]  name              node name
+   *
+   * @return  std::vector<int>     node shape
+   */
+  std::vector<int> getNodeShape(const std::string& name) const {
+
+    const auto it = node_shapes_.find(name);
+    if (it != node_shapes_.end()) {
+      return it->second;
+    } else if (is_saved_model_) {
+      return {};
+    } else if (is_frozen_graph_) {
+      return graph_index_.nodeShape(name);
+    } else {
+      return {};
+    }
+  }
+
+  /**
+   * @brief Determines the shape of the model input.
+   *
+   * This function works without having to specify input/output names of the
+   * model, but is limited to single-input/single-output models.
+   *
+   * @return  std::vector<int>  node shape
+   */
+  std::vector<int> getInputShape() const {
+
+    if (n_inputs_ != 1) {
+      throw std::runtime_error(
+        "std::vector<int> tensorflow_cpp::Model::getInputShape()' is only "
+        "available for single-input models. Found " +
+        std::to_string(n_inputs_) + " inputs.");
+    }
+
+    return getNodeShape(input_names_[0]);
+  }
+
+  /**
+   * @brief Determines the shape of the model output.
+   *
+   * This function works without having to specify input/output names of the
+   * model, but is limited to single-input/single-output models.
+   *
+   * @return  std::vector<int>  node shape
+   */
+  std::vector<int> getOutputShape() const {
+
+    if (n_outputs_ != 1) {
+      throw std::runtime_error(
+        "std::vector<int> tensorflow_cpp::Model::getOutputShape()' is only "
+        "available for single-output models. Found " +
+        std::to_string(n_outputs_) + " outputs.");
+    }
+
+    return getNodeShape(output_names_[0]);
   }
 
   /**
-   * @brief Determines the shape of the model output.
+   * @brief Determines the shape of the model inputs.
+   *
+   * @return  const std::vector<std::vector<int>>&  node shapes
+   */
+  const std::vector<std::vector<int>>& getInputShapes() const {
+    return input_shapes_;
+  }
+
+  /**
+   * @brief Determines the shape of the model outputs.
+   *
+   * @return  const std::vector<std::vector<int>>&  node shapes
+   */
+  const std::vector<std::vector<int>>& getOutputShapes() const {
+    return output_shapes_;
+  }
+
+  /**
+   * @brief Determines the datatype of a model node.
+   *
+   * @param[in]  name          node name
+   *
+   * @return  tf::DataType     node datatype
+   */
+  tf::DataType getNodeType(const std::string& name) const {
+
+    const auto it = node_types_.find(name);
+    if (it != node_types_.end()) {
+      return it->second;
+    } else if (is_saved_model_) {
+      return tf::DT_INVALID;
+    } else if (is_frozen_graph_) {
+      return graph_index_.nodeType(name);
+    } else {
+      return tf::DataType();
+    }
+  }
+
+  /**
+   * @brief Determines the datatype of the model input.
+   *
+   * This function works without having to specify input/output names of the
+   * model, but is limited to single-input/single-output models.
+   *
+   * @return  tf::DataType  node datatype
+   */
+  tf::DataType getInputType() const {
+
+    if (n_inputs_ != 1) {
+      throw std::runtime_error(
+        "'tf::DataType tensorflow_cpp::Model::getInputType()' is only "
+        "available for single-input models. Found " +
+        std::to_string(n_inputs_) + " inputs.");
+    }
+
+    return getNodeType(input_names_[0]);
+  }
+
+  /**
+   * @brief Determines the datatype of the model output.
+   *
+   * This function works without having to specify input/output names of the
+   * model, but is limited to single-input/single-output models.
+   *
+   * @return  tf::DataType  node datatype
+   */
+  tf::DataType getOutputType() const {
+
+    if (n_outputs_ != 1) {
+      throw std::runtime_error(
+        "'tf::DataType tensorflow_cpp::Model::getOutputType()' is only "
+        "available for single-output models. Found " +
+        std::to_string(n_outputs_) + " outputs.");
+    }
+
+    return getNodeType(output_names_[0]);
+  }
+
+  /**
+   * @brief Determines the datatype of the model inputs.
+   *
+   * @return  const std::vector<tf::DataType>&  node datatypes
+   */
+  const std::vector<tf::DataType>& getInputTypes() const {
+    return input_types_;
+  }
+
+  /**
+   * @brief Determines the datatype of the model outputs.
+   *
+   * @return  const std::vector<tf::DataType>&  node datatypes
+   */
+  const std::vector<tf::DataType>& getOutputTypes() const {
+    return output_types_;
+  }
+
+  /**
+   * @brief Returns the datatypes and shapes input tensors are checked
+   * against, see `SessionConfig::input_validation`.
+   *
+   * @return  const std::vector<InputSpec>&  input specs, in order of
+   * `inputNames`
+   */
+  const std::vector<InputSpec>& inputSpecs() const {
+    return input_specs_;
+  }
+
+  /**
+   * @brief Returns information about the model.
+   *
+   * Returns a formatted message containing information about the shape and type
+   * of all inputs/outputs of the model.
+   *
+   * @return  const std::string&  formatted info message
+   */
+  const std::string& getInfoString() const {
+    return info_string_;
+  }
+
+  /**
+   * @brief Returns the configuration the session was created with.
+   *
+   * @return  const SessionConfig&  session configuration
+   */
+  const SessionConfig& sessionConfig() const {
+    return session_config_;
+  }
+
+  /**
+   * @brief Determines the memory statistics of the allocator of a device.
+   *
+   * Allocators are shared by all sessions running on the same (virtual)
+   * device, see `SessionConfig::gpu_memory_limits_mb` for separating models.
+   *
+   * @param[in]  device        device name (empty: the model's device, i.e.,
+   *                           `SessionConfig::device` or the first GPU)
+   *
+   * @return  MemoryStats      memory statistics
+   */
+  MemoryStats memoryStats(const std::string& device = "") const {
+
+    if (!session_)
+      throw std::runtime_error("Cannot query memory of unloaded model");
+
+    return getSessionDeviceMemoryStats(
+      session_, device.empty() ? memoryDevice() : device);
+  }
+
+  /**
+   * @brief Returns the underlying TensorFlow session.
+   *
+   * @return  tf::Session*  session
+   */
+  tf::Session* session() const {
+    return session_;
+  }
+
+  /**
+   * @brief Returns the underlying SavedModel.
+   *
+   * @return  const tf::SavedModelBundleLite&  SavedModel
+   */
+  const tf::SavedModelBundleLite& savedModel() const {
+    return saved_model_;
+  }
+
+  /**
+   * @brief Returns the underlying FrozenGraph GraphDef.
+   *
+   * @return  const tf::GraphDef& FrozenGraph GraphDef
+   */
+  const tf::GraphDef& frozenGraph() const {
+    return graph_def_;
+  }
+
+  /**
+   * @brief Releases all but the input/output nodes of the FrozenGraph GraphDef.
+   *
+   * The session keeps its own copy of the graph, so the GraphDef is only
+   * needed for querying information about inputs/outputs. Afterwards,
+   * `frozenGraph` only contains the input/output nodes.
+   */
+  void releaseGraphDef() {
+
+    std::vector<std::string> io_nodes = input_nodes_;
+    io_nodes.insert(io_nodes.end(), output_nodes_.begin(), output_nodes_.end());
+    tf::GraphDef io_graph_def = extractGraphNodes(graph_def_, io_nodes);
+    graph_def_.Swap(&io_graph_def);
+  }
+
+  /**
+   * @brief Returns whether loaded model is from SavedModel.
+   *
+   * @return  true   if loaded from SavedModel
+   * @return  false  if not loaded from SavedModel
+   */
+  bool isSavedModel() const {
+    return is_saved_model_;
+  }
+
+  /**
+   * @brief Returns whether loaded model is from FrozenGraph.
+   *
+   * @return  true   if loaded from FrozenGraph
+   * @return  false  if not loaded from FrozenGraph
+   */
+  bool isFrozenGraph() const {
+    return is_frozen_graph_;
+  }
+
+  /**
+   * @brief Returns number of model inputs.
+   *
+   * @return  int  number of inputs
+   */
+  int nInputs() const {
+    return n_inputs_;
+  }
+
+  /**
+   * @brief Returns number of model outputs.
+   *
+   * @return  int  number of outputs
+   */
+  int nOutputs() const {
+    return n_outputs_;
+  }
+
+  /**
+   * @brief Returns names of model inputs.
+   *
+   * @return  std::vector<std::string>  model input names
+   */
+  std::vector<std::string> inputNames() const {
+    return input_names_;
+  }
+
+  /**
+   * @brief Returns names of model outputs.
+   *
+   * @return  std::vector<std::string>  model output names
+   */
+  std::vector<std::string> outputNames() const {
+    return output_names_;
+  }
+
+  /**
+   * @brief Returns node names of model inputs.
+   *
+   * For FrozenGraphs, these are equal to `inputNames`.
+   *
+   * @return  std::vector<std::string>  model input node names
+   */
+  std::vector<std::string> inputNodeNames() const {
+    return input_nodes_;
+  }
+
+  /**
+   * @brief Returns node names of model outputs.
+   *
+   * For FrozenGraphs, these are equal to `outputNames`.
+   *
+   * @return  std::vector<std::string>  model output node names
+   */
+  std::vector<std::string> outputNodeNames() const {
+    return output_nodes_;
+  }
+
+  /**
+   * @brief Determines the index of a model input.
+   *
+   * The index refers to the order given by `inputNames` and can be used to
+   * run the model without per-call name lookups.
+   *
+   * @param[in]  name  input name
+   *
+   * @return  int      input index
+   */
+  int inputIndex(const std::string& name) const {
+
+    const auto it = std::find(input_names_.begin(), input_names_.end(), name);
+    if (it == input_names_.end())
+      throw std::runtime_error("Unknown model input '" + name + "'");
+
+    return it - input_names_.begin();
+  }
+
+  /**
+   * @brief Determines the index of a model output.
+   *
+   * The index refers to the order given by `outputNames` and can be used to
+   * run the model without per-call name lookups.
+   *
+   * @param[in]  name  output name
+   *
+   * @return  int      output index
+   */
+  int outputIndex(const std::string& name) const {
+
+    const auto it =
+      std::find(output_names_.begin(), output_names_.end(), name);
+    if (it == output_names_.end())
+      throw std::runtime_error("Unknown model output '" + name + "'");
+
+    return it - output_names_.begin();
+  }
+
+  /**
+   * @brief Creates zero-filled input tensors matching the model inputs.
+   *
+   * Shapes and datatypes are inferred from `getInputShapes` and
+   * `getInputTypes`. A dynamic batch dimension is set to `batch_size`, any
+   * other unknown dimension to 1.
+   *
+   * @param[in]  batch_size               batch size for dynamic batch dimension
+   *
+   * @return  std::vector<tf::Tensor>     input tensors
+   */
+  std::vector<tf::Tensor> makeDummyInputs(const int batch_size = 1) const {
+
+    // infer input shapes/types to create dummy input tensors
+    auto input_shapes = getInputShapes();
+    auto input_types = getInputTypes();
+    std::vector<tf::Tensor> input_dummies;
+    for (int k = 0; k < n_inputs_; k++) {
+      std::vector<long int> dummy_shape(input_shapes[k].begin(),
+                                        input_shapes[k].end());
+      // Replace -1 (batch size dimension, None in python) with batch size,
+      // any other unknown dimensions with 1
+      if (!dummy_shape.empty() && dummy_shape[0] == -1l)
+        dummy_shape[0] = batch_size;
+      std::replace(dummy_shape.begin(), dummy_shape.end(), -1l, 1l);
+      auto dummy_tensor_shape =
+        tf::TensorShape(tf::gtl::ArraySlice<long int>(dummy_shape));
+      input_dummies.push_back(
+        makeZeroTensor(input_types[k], dummy_tensor_shape));
+    }
+
+    return input_dummies;
+  }
+
+ protected:
+  /**
+   * @brief Determines the node name to pass to the session for a given name.
+   *
+   * SavedModel layer names are translated to node names, FrozenGraph names
+   * are already node names.
+   *
+   * @param[in]  name     input/output name
+   *
+   * @return  std::string node name
+   */
+  std::string getNodeName(const std::string& name) const {
+
+    if (!is_saved_model_) return name;
+    const auto it = saved_model_layer2node_.find(name);
+    if (it == saved_model_layer2node_.end())
+      throw std::runtime_error("Unknown SavedModel input/output '" + name +
+                               "'");
+
+    return it->second;
+  }
+
+  /**
+   * @brief Precompiles a callable for given input/output nodes.
    *
-   * This function works without having to specify input/output names of the
-   * model, but is limited to single-input/single-output models.
+   * @param[in]  input_names    (layer) names of inputs
+   * @param[in]  output_names   (layer) names of outputs
+   * @param[in]  input_nodes     node names of inputs
+   * @param[in]  output_nodes    node names of outputs
+   * @param[in]  input_devices   device per input (empty string or vector:
+   * host)
+   * @param[in]  output_devices  device per output (empty string or vector:
+   * host)
    *
-   * @return  std::vector<int>  node shape
+   * @return  Callable           callable
    */
-  std::vector<int> getOutputShape() {
-
-    if (n_outputs_ != 1) {
-      throw std::runtime_error(
-        "std::vector<int> tensorflow_cpp::Model::getOutputShape()' is only "
-        "available for single-output models. Found " +
-        std::to_string(n_outputs_) + " outputs.");
+  Callable makeNodeCallable(
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::vector<std::string>& input_nodes,
+    const std::vector<std::string>& output_nodes,
+    const std::vector<std::string>& input_devices,
+    const std::vector<std::string>& output_devices) const {
+
+    // the callable's device is the first non-host device, if any
+    std::string input_device;
+    std::string output_device;
+    tf::CallableOptions options;
+    for (int k = 0; k < input_nodes.size(); k++) {
+      options.add_feed(input_nodes[k]);
+      if (k < input_devices.size() && !input_devices[k].empty()) {
+        (*options.mutable_feed_devices())[input_nodes[k]] = input_devices[k];
+        if (input_device.empty()) input_device = input_devices[k];
+      }
+    }
+    for (int k = 0; k < output_nodes.size(); k++) {
+      options.add_fetch(output_nodes[k]);
+      if (k < output_devices.size() && !output_devices[k].empty()) {
+        (*options.mutable_fetch_devices())[output_nodes[k]] = output_devices[k];
+        if (output_device.empty()) output_device = output_devices[k];
+      }
+    }
+    if (!output_device.empty()) options.set_fetch_skip_sync(true);
+
+    Callable callable;
+    tf::Status status = session_->MakeCallable(options, &callable.handle);
+    if (!status.ok())
+      throw std::runtime_error("Failed to make callable: " + status.ToString());
+    callable.is_valid = true;
+    callable.input_names = input_names;
+    callable.output_names = output_names;
+    callable.input_nodes = input_nodes;
+    callable.output_nodes = output_nodes;
+    callable.input_device = input_device;
+    callable.output_device = output_device;
+    for (const auto& name : input_names) {
+      const auto shape = node_shapes_.find(name);
+      const auto type = node_types_.find(name);
+      callable.input_specs.push_back(
+        {name, type != node_types_.end() ? type->second : tf::DT_INVALID,
+         shape != node_shapes_.end() ? shape->second : std::vector<int>()});
     }
 
-    return getNodeShape(output_names_[0]);
+    return callable;
   }
 
   /**
-   * @brief Determines the shape of the model inputs.
+   * @brief Determines the device whose memory the model mainly uses.
    *
-   * @return  std::vector<std::vector<int>>  node shapes
+   * @return  std::string  `SessionConfig::device`, or the first GPU, or the
+   * CPU
    */
-  std::vector<std::vector<int>> getInputShapes() {
+  std::string memoryDevice() const {
 
-    std::vector<std::vector<int>> shapes;
-    for (const auto& name : input_names_) shapes.push_back(getNodeShape(name));
+    if (!session_config_.device.empty()) return session_config_.device;
+    const std::string gpu = getSessionGpuDeviceName(session_);
 
-    return shapes;
+    return gpu.empty() ? "/device:CPU:0" : gpu;
   }
 
   /**
-   * @brief Determines the shape of the model outputs.
+   * @brief Resolves the inputs/outputs of a SavedModel signature.
    *
-   * @return  std::vector<std::vector<int>>  node shapes
+   * @param[in]  saved_model  SavedModel
+   * @param[in]  name         signature name
+   *
+   * @return  Signature       signature, without callable
    */
-  std::vector<std::vector<int>> getOutputShapes() {
-
-    std::vector<std::vector<int>> shapes;
-    for (const auto& name : output_names_) shapes.push_back(getNodeShape(name));
+  static Signature makeSignature(const tf::SavedModelBundleLite& saved_model,
+                                 const std::string& name) {
+
+    Signature signature;
+    signature.name = name;
+    signature.input_names = getSavedModelInputNames(saved_model, true, name);
+    signature.output_names = getSavedModelOutputNames(saved_model, true, name);
+    signature.input_nodes = getSavedModelInputNames(saved_model, false, name);
+    signature.output_nodes = getSavedModelOutputNames(saved_model, false, name);
+    for (int k = 0; k < signature.input_names.size(); k++)
+      signature.layer2node[signature.input_names[k]] = signature.input_nodes[k];
+    for (int k = 0; k < signature.output_names.size(); k++)
+      signature.layer2node[signature.output_names[k]] =
+        signature.output_nodes[k];
+
+    // resolve shapes and datatypes once instead of per query
+    const tf::SignatureDef& signature_def =
+      saved_model.GetSignatures().at(name);
+    for (const auto& layer : signature.input_names) {
+      const tf::TensorInfo* info =
+        findSavedModelTensorInfo(signature_def, layer);
+      signature.input_shapes.push_back(getTensorInfoShape(*info));
+      signature.input_types.push_back(info->dtype());
+    }
+    for (const auto& layer : signature.output_names) {
+      const tf::TensorInfo* info =
+        findSavedModelTensorInfo(signature_def, layer);
+      signature.output_shapes.push_back(getTensorInfoShape(*info));
+      signature.output_types.push_back(info->dtype());
+    }
 
-    return shapes;
+    return signature;
   }
 
   /**
-   * @brief Determines the datatype of a model node.
+   * @brief Checks whether inputs have to be split into micro-batches.
    *
-   * @param[in]  name          node name
+   * @param[in]  input_tensors  input tensors
    *
-   * @return  tf::DataType     node datatype
+   * @return  true              if batch exceeds maximum micro-batch size
+   * @return  false             otherwise
    */
-  tf::DataType getNodeType(const std::string& name) {
+  bool isMicroBatched(const std::vector<tf::Tensor>& input_tensors) const {
 
-    if (is_saved_model_) {
-      return getSavedModelNodeType(saved_model_, saved_model_layer2node_[name]);
-    } else if (is_frozen_graph_) {
-      return getGraphNodeType(graph_def_, name);
-    } else {
-      return tf::DataType();
-    }
+    return micro_batch_size_ > 0 && !input_tensors.empty() &&
+           input_tensors[0].dims() > 0 &&
+           input_tensors[0].dim_size(0) > micro_batch_size_;
   }
 
   /**
-   * @brief Determines the datatype of the model input.
+   * @brief Runs inputs split into micro-batches, see `setMicroBatching`.
    *
-   * This function works without having to specify input/output names of the
-   * model, but is limited to single-input/single-output models.
+   * @param[in]  input_tensors            input tensors
    *
-   * @return  tf::DataType  node datatype
+   * @return  std::vector<tf::Tensor>     output tensors
    */
-  tf::DataType getInputType() {
+  std::vector<tf::Tensor> runMicroBatched(
+    const std::vector<tf::Tensor>& input_tensors) const {
 
-    if (n_inputs_ != 1) {
-      throw std::runtime_error(
-        "'tf::DataType tensorflow_cpp::Model::getInputType()' is only "
-        "available for single-input models. Found " +
-        std::to_string(n_inputs_) + " inputs.");
+    const tf::int64 batch_size = input_tensors[0].dim_size(0);
+    for (const auto& input : input_tensors) {
+      if (input.dims() == 0 || input.dim_size(0) != batch_size)
+        throw std::runtime_error(
+          "Cannot split inputs with differing batch dimensions");
     }
+    const tf::int64 n_micro_batches =
+      (batch_size + micro_batch_size_ - 1) / micro_batch_size_;
+
+    // slices share the input buffers, unaligned slices are copied
+    auto runMicroBatch = [this, &input_tensors,
+                          batch_size](const tf::int64 idx) {
+      const tf::int64 start = idx * micro_batch_size_;
+      const tf::int64 end = std::min(start + micro_batch_size_, batch_size);
+      std::vector<tf::Tensor> micro_batch;
+      for (const auto& input : input_tensors) {
+        tf::Tensor slice = input.Slice(start, end);
+        micro_batch.push_back(slice.IsAligned() ? slice
+                                                : tf::tensor::DeepCopy(slice));
+      }
+      return (*this)(micro_batch);
+    };
 
-    return getNodeType(input_names_[0]);
+    // copy micro-batch outputs into outputs, allocated on first micro-batch
+    std::vector<tf::Tensor> output_tensors;
+    auto collectMicroBatch = [&output_tensors, batch_size, this](
+                               const tf::int64 idx,
+                               const std::vector<tf::Tensor>& outputs) {
+      const tf::int64 start = idx * micro_batch_size_;
+      const tf::int64 size =
+        std::min<tf::int64>(micro_batch_size_, batch_size - start);
+      if (output_tensors.empty()) {
+        for (const auto& output : outputs) {
+          if (output.dims() == 0 || output.dim_size(0) != size)
+            throw std::runtime_error(
+              "Cannot micro-batch model with unbatched outputs");
+          tf::TensorShape shape = output.shape();
+          shape.set_dim(0, batch_size);
+          output_tensors.emplace_back(output.dtype(), shape);
+        }
+      }
+      for (int k = 0; k < outputs.size(); k++) {
+        tf::Status status = tf::batch_util::CopyContiguousSlices(
+          outputs[k], 0, start, size, &output_tensors[k]);
+        if (!status.ok())
+          throw std::runtime_error("Failed to collect micro-batch outputs: " +
+                                   status.ToString());
+      }
+    };
+
+    if (!micro_batch_pool_) {
+      for (tf::int64 idx = 0; idx < n_micro_batches; idx++)
+        collectMicroBatch(idx, runMicroBatch(idx));
+      return output_tensors;
+    }
+
+    // keep a bounded window of micro-batches in flight, collected in order
+    const tf::int64 n_parallel = micro_batch_pool_->nThreads();
+    std::deque<std::future<std::vector<tf::Tensor>>> in_flight;
+    tf::int64 next = 0;
+    try {
+      for (tf::int64 idx = 0; idx < n_micro_batches; idx++) {
+        while (next < n_micro_batches && next < idx + n_parallel) {
+          const tf::int64 submitted = next++;
+          in_flight.push_back(micro_batch_pool_->submit(
+            [runMicroBatch, submitted]() { return runMicroBatch(submitted); }));
+        }
+        std::vector<tf::Tensor> outputs = in_flight.front().get();
+        in_flight.pop_front();
+        collectMicroBatch(idx, outputs);
+      }
+    } catch (...) {
+      // pending micro-batches reference the inputs
+      for (auto& pending : in_flight)
+        if (pending.valid()) pending.wait();
+      throw;
+    }
+
+    return output_tensors;
   }
 
   /**
-   * @brief Determines the datatype of the model output.
+   * @brief Runs the session, collecting a full trace if requested.
    *
-   * This function works without having to specify input/output names of the
-   * model, but is limited to single-input/single-output models.
+   * @param[in]   input_nodes        inputs by node name
+   * @param[in]   output_node_names  output node names
+   * @param[out]  output_tensors     output tensors
+   * @param[in]   profiling          profiling scope of the current call
    *
-   * @return  tf::DataType  node datatype
+   * @return  tf::Status             session status
    */
-  tf::DataType getOutputType() {
+  tf::Status runSession(
+    const std::vector<std::pair<std::string, tf::Tensor>>& input_nodes,
+    const std::vector<std::string>& output_node_names,
+    std::vector<tf::Tensor>* output_tensors, ProfilingScope& profiling) const {
 
-    if (n_outputs_ != 1) {
-      throw std::runtime_error(
-        "'tf::DataType tensorflow_cpp::Model::getOutputType()' is only "
-        "available for single-output models. Found " +
-        std::to_string(n_outputs_) + " outputs.");
+    tf::Status status;
+    ObserverScope observation(observer_.get(), name());
+    observation.begin(input_nodes);
+    profiling.beginSession();
+    if (profiling.runMetadata()) {
+      tf::RunOptions run_options;
+      run_options.set_trace_level(tf::RunOptions::FULL_TRACE);
+      status = session_->Run(run_options, input_nodes, output_node_names, {},
+                             output_tensors, profiling.runMetadata());
+    } else {
+      status =
+        session_->Run(input_nodes, output_node_names, {}, output_tensors);
     }
+    profiling.endSession(status);
+    observation.end(status);
 
-    return getNodeType(output_names_[0]);
+    return status;
   }
 
   /**
-   * @brief Determines the datatype of the model inputs.
+   * @brief Checks that the number of input tensors matches the model.
    *
-   * @return  std::vector<tf::DataType>  node datatypes
+   * @param[in]  input_tensors  input tensors
    */
-  std::vector<tf::DataType> getInputTypes() {
-
-    std::vector<tf::DataType> types;
-    for (const auto& name : input_names_) types.push_back(getNodeType(name));
+  void checkNumInputs(const std::vector<tf::Tensor>& input_tensors) const {
 
-    return types;
+    if (input_tensors.size() != n_inputs_) {
+      throw std::runtime_error(
+        "Model has " + std::to_string(n_inputs_) + " inputs, but " +
+        std::to_string(input_tensors.size()) + " input tensors were given");
+    }
   }
 
   /**
-   * @brief Determines the datatype of the model outputs.
+   * @brief Checks an input tensor, see `SessionConfig::input_validation`.
    *
-   * @return  std::vector<tf::DataType>  node datatypes
+   * @param[in]  idx     input index
+   * @param[in]  tensor  input tensor
+   *
+   * @return  true       if the tensor can be fed as is
+   * @return  false      if the tensor has to be converted first
    */
-  std::vector<tf::DataType> getOutputTypes() {
-
-    std::vector<tf::DataType> types;
-    for (const auto& name : output_names_) types.push_back(getNodeType(name));
+  /**
+   * @brief Runs a precompiled callable on inputs that were already checked.
+   *
+   * See `run(const Callable&, const std::vector<tf::Tensor>&,
+   * std::vector<tf::Tensor>&)`.
+   *
+   * @param[in]   callable        valid callable
+   * @param[in]   input_tensors   input tensors
+   * @param[out]  output_tensors  output tensors
+   */
+  void runCallable(const Callable& callable,
+                   const std::vector<tf::Tensor>& input_tensors,
+                   std::vector<tf::Tensor>& output_tensors) const {
 
-    return types;
+    // run model, traced calls fall back to session->Run() since the trace
+    // level of a callable is fixed on creation
+    ProfilingScope profiling(profiler_.get());
+    tf::Status status;
+    if (profiling.runMetadata() && callable.input_device.empty() &&
+        callable.output_device.empty()) {
+      std::vector<std::pair<std::string, tf::Tensor>> input_nodes;
+      std::vector<std::string> output_node_names;
+      for (int k = 0; k < input_tensors.size(); k++)
+        input_nodes.emplace_back(callable.input_nodes[k], input_tensors[k]);
+      status = runSession(input_nodes, callable.output_nodes, &output_tensors,
+                          profiling);
+    } else {
+      // device callables cannot be traced, don't count them as traced calls
+      profiling.dropTrace();
+      ObserverScope observation(observer_.get(), name());
+      observation.begin(input_tensors);
+      profiling.beginSession();
+      status = session_->RunCallable(callable.handle, input_tensors,
+                                     &output_tensors, nullptr);
+      profiling.endSession(status);
+      observation.end(status);
+    }
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
   }
 
   /**
-   * @brief Returns information about the model.
+   * @brief Runs a precompiled callable on inputs that were already checked.
    *
-   * Returns a formatted message containing information about the shape and type
-   * of all inputs/outputs of the model.
+   * @param[in]  callable                 valid callable
+   * @param[in]  input_tensors            input tensors
    *
-   * @return  std::string  formatted info message
+   * @return  std::vector<tf::Tensor>     output tensors
    */
-  std::string getInfoString() {
+  std::vector<tf::Tensor> runCallable(
+    const Callable& callable,
+    const std::vector<tf::Tensor>& input_tensors) const {
 
-    if (is_saved_model_) {
-      return getSavedModelInfoString(saved_model_);
-    } else if (is_frozen_graph_) {
-      return getGraphInfoString(graph_def_);
-    } else {
-      return "";
-    }
+    std::vector<tf::Tensor> output_tensors;
+    runCallable(callable, input_tensors, output_tensors);
+
+    return output_tensors;
+  }
+
+  bool checkInput(const int idx, const tf::Tensor& tensor) const {
+
+    return checkInput(input_specs_[idx], tensor);
   }
 
   /**
-   * @brief Returns the underlying TensorFlow session.
+   * @brief Checks an input tensor against an input spec, see
+   * `SessionConfig::input_validation`.
    *
-   * @return  tf::Session*  session
+   * @param[in]  spec    input spec
+   * @param[in]  tensor  input tensor
+   *
+   * @return  true       if the tensor can be fed as is
+   * @return  false      if the tensor has to be converted first
    */
-  tf::Session* session() const {
-    return session_;
+  bool checkInput(const InputSpec& spec, const tf::Tensor& tensor) const {
+
+#ifndef TENSORFLOW_CPP_DISABLE_INPUT_VALIDATION
+    const InputValidation mode = session_config_.input_validation;
+    if (mode == InputValidation::kNone || matchesInputSpec(spec, tensor))
+      return true;
+    if (mode == InputValidation::kCheck)
+      throw std::runtime_error(describeInputMismatch(spec, tensor));
+    return false;
+#else
+    return true;
+#endif
   }
 
   /**
-   * @brief Returns the underlying SavedModel.
+   * @brief Checks input tensors in the order given by `inputNames`.
    *
-   * @return  const tf::SavedModelBundleLite&  SavedModel
+   * @param[in]  input_tensors  input tensors
+   *
+   * @return  true              if all tensors can be fed as is
+   * @return  false             if any tensor has to be converted first
    */
-  const tf::SavedModelBundleLite& savedModel() const {
-    return saved_model_;
+  bool checkInputs(const std::vector<tf::Tensor>& input_tensors) const {
+
+    bool can_feed = true;
+    for (int k = 0; k < input_tensors.size() && k < n_inputs_; k++)
+      can_feed = checkInput(k, input_tensors[k]) && can_feed;
+
+    return can_feed;
   }
 
   /**
-   * @brief Returns the underlying FrozenGraph GraphDef.
+   * @brief Checks input tensors against input specs, in spec order.
    *
-   * @return  const tf::GraphDef& FrozenGraph GraphDef
+   * @param[in]  specs          input specs
+   * @param[in]  input_tensors  input tensors
+   *
+   * @return  true              if all tensors can be fed as is
+   * @return  false             if any tensor has to be converted first
    */
-  const tf::GraphDef& frozenGraph() const {
-    return graph_def_;
+  bool checkInputs(const std::vector<InputSpec>& specs,
+                   const std::vector<tf::Tensor>& input_tensors) const {
+
+    bool can_feed = true;
+    for (int k = 0; k < input_tensors.size() && k < specs.size(); k++)
+      can_feed = checkInput(specs[k], input_tensors[k]) && can_feed;
+
+    return can_feed;
   }
 
   /**
-   * @brief Returns whether loaded model is from SavedModel.
+   * @brief Converts input tensors that do not match their input specs.
    *
-   * @return  true   if loaded from SavedModel
-   * @return  false  if not loaded from SavedModel
+   * @param[in]  specs                    input specs
+   * @param[in]  input_tensors            input tensors, in spec order
+   *
+   * @return  std::vector<tf::Tensor>     matching input tensors
    */
-  bool isSavedModel() const {
-    return is_saved_model_;
+  std::vector<tf::Tensor> convertInputs(
+    const std::vector<InputSpec>& specs,
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    std::vector<tf::Tensor> converted = input_tensors;
+    for (int k = 0; k < converted.size() && k < specs.size(); k++)
+      if (!checkInput(specs[k], converted[k]))
+        converted[k] = convertInput(specs[k], converted[k]);
+
+    return converted;
   }
 
   /**
-   * @brief Returns whether loaded model is from FrozenGraph.
+   * @brief Determines the input specs of a signature.
    *
-   * @return  true   if loaded from FrozenGraph
-   * @return  false  if not loaded from FrozenGraph
+   * @param[in]  signature                signature
+   *
+   * @return  std::vector<InputSpec>      input specs, in order of the
+   * signature's `input_names`
    */
-  bool isFrozenGraph() const {
-    return is_frozen_graph_;
+  static std::vector<InputSpec> signatureInputSpecs(
+    const Signature& signature) {
+
+    std::vector<InputSpec> specs;
+    for (int k = 0; k < signature.input_names.size(); k++)
+      specs.push_back({signature.input_names[k], signature.input_types[k],
+                       signature.input_shapes[k]});
+
+    return specs;
   }
 
   /**
-   * @brief Returns number of model inputs.
+   * @brief Checks an input tensor and converts it if necessary.
    *
-   * @return  int  number of inputs
+   * @param[in]      idx     input index
+   * @param[in,out]  tensor  input tensor
    */
-  int nInputs() const {
-    return n_inputs_;
+  void prepareInput(const int idx, tf::Tensor& tensor) const {
+
+    if (!checkInput(idx, tensor))
+      tensor = convertInput(input_specs_[idx], tensor);
   }
 
   /**
-   * @brief Returns number of model outputs.
+   * @brief Checks input tensors and converts them if necessary.
    *
-   * @return  int  number of outputs
+   * @param[in,out]  input_tensors  input tensors, in order of `inputNames`
    */
-  int nOutputs() const {
-    return n_outputs_;
+  void prepareInputs(std::vector<tf::Tensor>& input_tensors) const {
+
+    for (int k = 0; k < input_tensors.size() && k < n_inputs_; k++)
+      prepareInput(k, input_tensors[k]);
   }
 
   /**
-   * @brief Returns names of model inputs.
+   * @brief Checks input tensors given by name and converts them if
+   * necessary; tensors fed to other nodes are left unchecked.
    *
-   * @return  std::vector<std::string>  model input names
+   * @param[in,out]  inputs  inputs by name
    */
-  std::vector<std::string> inputNames() const {
-    return input_names_;
+  void prepareInputs(
+    std::vector<std::pair<std::string, tf::Tensor>>& inputs) const {
+
+#ifndef TENSORFLOW_CPP_DISABLE_INPUT_VALIDATION
+    if (session_config_.input_validation == InputValidation::kNone) return;
+    for (auto& input : inputs) {
+      const auto it =
+        std::find(input_names_.begin(), input_names_.end(), input.first);
+      if (it != input_names_.end())
+        prepareInput(it - input_names_.begin(), input.second);
+    }
+#endif
   }
 
   /**
-   * @brief Returns names of model outputs.
+   * @brief Runs the session on the default output nodes.
    *
-   * @return  std::vector<std::string>  model output names
+   * The output tensors are returned as produced by `session->Run()`, in the
+   * order given by `outputNames`.
+   *
+   * @param[in]  input_nodes              input tensors by node name
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
    */
-  std::vector<std::string> outputNames() const {
-    return output_names_;
+  std::vector<tf::Tensor> runDefault(
+    const std::vector<std::pair<std::string, tf::Tensor>>& input_nodes) const {
+
+    if (!session_) return {};
+
+    ProfilingScope profiling(profiler_.get());
+    std::vector<tf::Tensor> output_tensors;
+    tf::Status status =
+      runSession(input_nodes, output_nodes_, &output_tensors, profiling);
+    if (!status.ok())
+      throw std::runtime_error("Failed to run model: " + status.ToString());
+
+    return output_tensors;
   }
 
- protected:
   /**
    * @brief Runs the model once with dummy input to speed-up first inference.
    */
   void dummyCall() {
 
-    // infer input shapes/types to create dummy input tensors
-    auto input_shapes = getInputShapes();
-    auto input_types = getInputTypes();
-    std::vector<tf::Tensor> input_dummies;
-    for (int k = 0; k < n_inputs_; k++) {
-      std::vector<long int> dummy_shape(input_shapes[k].begin(),
-                                        input_shapes[k].end());
-      // Replace -1 (batch size dimension, None in python) with 1
-      std::replace(dummy_shape.begin(), dummy_shape.end(), -1l, 1l);
-      auto dummy_tensor_shape =
-        tf::TensorShape(tf::gtl::ArraySlice<long int>(dummy_shape));
-      tf::Tensor dummy(input_types[k], dummy_tensor_shape);
-      // init to zero, based on type
-      switch (input_types[k]) {
-        case tf::DT_FLOAT:
-          dummy.flat<float>().setZero();
-          break;
-        case tf::DT_DOUBLE:
-          dummy.flat<double>().setZero();
-        case tf::DT_INT32:
-          dummy.flat<tf::int32>().setZero();
-          break;
-        case tf::DT_UINT32:
-          dummy.flat<tf::uint32>().setZero();
-          break;
-        case tf::DT_UINT8:
-          dummy.flat<tf::uint8>().setZero();
-          break;
-        case tf::DT_UINT16:
-          dummy.flat<tf::uint16>().setZero();
-          break;
-        case tf::DT_INT16:
-          dummy.flat<tf::int16>().setZero();
-          break;
-        case tf::DT_INT8:
-          dummy.flat<tf::int8>().setZero();
-          break;
-        case tf::DT_STRING:
-          dummy.flat<tf::tstring>().setZero();
-          break;
-        case tf::DT_COMPLEX64:
-          dummy.flat<tf::complex64>().setZero();
-          break;
-        case tf::DT_COMPLEX128:
-          dummy.flat<tf::complex128>().setZero();
-          break;
-        case tf::DT_INT64:
-          dummy.flat<tf::int64>().setZero();
-          break;
-        case tf::DT_UINT64:
-          dummy.flat<tf::uint64>().setZero();
-          break;
-        case tf::DT_BOOL:
-          dummy.flat<bool>().setZero();
-          break;
-        case tf::DT_QINT8:
-          dummy.flat<tf::qint8>().setZero();
-          break;
-        case tf::DT_QUINT8:
-          dummy.flat<tf::quint8>().setZero();
-          break;
-        case tf::DT_QUINT16:
-          dummy.flat<tf::quint16>().setZero();
-          break;
-        case tf::DT_QINT16:
-          dummy.flat<tf::qint16>().setZero();
-          break;
-        case tf::DT_QINT32:
-          dummy.flat<tf::qint32>().setZero();
-          break;
-        case tf::DT_BFLOAT16:
-          dummy.flat<tf::bfloat16>().setZero();
-          break;
-        case tf::DT_HALF:
-          dummy.flat<Eigen::half>().setZero();
-          break;
-      }
-      input_dummies.push_back(dummy);
-    }
+    std::vector<tf::Tensor> input_dummies = makeDummyInputs();
 
     // run dummy inference
     volatile auto output_dummies = (*this)(input_dummies);
@@ -626,16 +2503,54 @@ class Model {
    */
   tf::Session* session_ = nullptr;
 
+  /**
+   * @brief whether the last load, including warmup, has completed
+   * successfully
+   */
+  bool is_loaded_ = false;
+
+  /**
+   * @brief path the model has been loaded from
+   */
+  std::string model_path_;
+
+  /**
+   * @brief configuration of the underlying session
+   */
+  SessionConfig session_config_;
+
   /**
    * @brief underlying SavedModel
    */
   tf::SavedModelBundleLite saved_model_;
 
+  /**
+   * @brief SavedModel signatures by name
+   */
+  std::map<std::string, Signature> signatures_;
+
   /**
    * @brief underlying FrozenGraph GraphDef
    */
   tf::GraphDef graph_def_;
 
+  /**
+   * @brief index of the FrozenGraph metadata, built once on load and kept
+   * when the GraphDef is released
+   */
+  GraphIndex graph_index_;
+
+  /**
+   * @brief environment mapping the constants of a memmapped FrozenGraph
+   */
+  std::unique_ptr<tf::MemmappedEnv> memmapped_env_;
+
+  /**
+   * @brief owned session of a FrozenGraph, destroyed before the memmapped
+   * environment
+   */
+  std::unique_ptr<tf::Session> frozen_graph_session_;
+
   /**
    * @brief whether loaded model is from SavedModel
    */
@@ -666,6 +2581,56 @@ class Model {
    */
   std::vector<std::string> output_names_;
 
+  /**
+   * @brief node names of model inputs, aligned with `input_names_`
+   */
+  std::vector<std::string> input_nodes_;
+
+  /**
+   * @brief node names of model outputs, aligned with `output_names_`
+   */
+  std::vector<std::string> output_nodes_;
+
+  /**
+   * @brief shapes of model inputs, aligned with `input_names_`
+   */
+  std::vector<std::vector<int>> input_shapes_;
+
+  /**
+   * @brief shapes of model outputs, aligned with `output_names_`
+   */
+  std::vector<std::vector<int>> output_shapes_;
+
+  /**
+   * @brief datatypes of model inputs, aligned with `input_names_`
+   */
+  std::vector<tf::DataType> input_types_;
+
+  /**
+   * @brief datatypes of model outputs, aligned with `output_names_`
+   */
+  std::vector<tf::DataType> output_types_;
+
+  /**
+   * @brief shapes of model inputs/outputs by (layer) name
+   */
+  std::unordered_map<std::string, std::vector<int>> node_shapes_;
+
+  /**
+   * @brief datatypes of model inputs/outputs by (layer) name
+   */
+  std::unordered_map<std::string, tf::DataType> node_types_;
+
+  /**
+   * @brief datatypes and shapes of model inputs, see `inputSpecs`
+   */
+  std::vector<InputSpec> input_specs_;
+
+  /**
+   * @brief model info message, see `getInfoString`
+   */
+  std::string info_string_;
+
   /**
    * @brief mapping between SavedModel node and layer input/output names
    */
@@ -675,6 +2640,70 @@ class Model {
    * @brief mapping between SavedModel layer and node input/output names
    */
   std::unordered_map<std::string, std::string> saved_model_layer2node_;
+
+  /**
+   * @brief precompiled callable for default inputs/outputs
+   */
+  Callable default_callable_;
+
+  /**
+   * @brief Preprocessing attached to a model input.
+   */
+  struct PreprocessingStage {
+
+    /**
+     * @brief preprocessing configuration
+     */
+    PreprocessingConfig config;
+
+    /**
+     * @brief datatype of the model input
+     */
+    tf::DataType dtype;
+
+    /**
+     * @brief rank of the model input (0: unknown)
+     */
+    int rank;
+  };
+
+  /**
+   * @brief preprocessing stages by model input index
+   */
+  std::unordered_map<int, PreprocessingStage> preprocessing_;
+
+  /**
+   * @brief profiler of model calls, only set if profiling is enabled
+   */
+  std::unique_ptr<Profiler> profiler_;
+
+  /**
+   * @brief observer notified around every session run, may be nullptr
+   */
+  std::shared_ptr<ModelObserver> observer_;
+
+  /**
+   * @brief name the model is reported with to observers (empty: model path)
+   */
+  std::string name_;
+
+  /**
+   * @brief maximum micro-batch size (0: micro-batching disabled)
+   */
+  int micro_batch_size_ = 0;
+
+  /**
+   * @brief thread pool running micro-batches concurrently, only set if more
+   * than one micro-batch runs at a time
+   */
+  std::unique_ptr<ThreadPool> micro_batch_pool_;
+
+  /**
+   * @brief thread pool for asynchronous runs, destroyed first to finish
+   * pending calls while the session is still alive
+   */
+  std::unique_ptr<ThreadPool> async_pool_ =
+    std::unique_ptr<ThreadPool>(new ThreadPool(1));
 };
 
 
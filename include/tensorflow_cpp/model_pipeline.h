@@ -0,0 +1,715 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ModelPipeline class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow_cpp/model.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Accumulated timing statistics of a pipeline stage.
+ */
+struct StageStats {
+
+  /**
+   * @brief number of processed frames
+   */
+  long n_frames = 0;
+
+  /**
+   * @brief accumulated time spent running the stage's model [ms]
+   */
+  double total_ms = 0;
+
+  /**
+   * @brief time of the slowest frame [ms]
+   */
+  double max_ms = 0;
+
+  /**
+   * @brief number of frames waiting in the stage's input queue
+   */
+  int queue_size = 0;
+
+  /**
+   * @brief Returns the mean time per frame.
+   *
+   * @return  double  mean time [ms]
+   */
+  double meanMs() const {
+    return (n_frames > 0) ? total_ms / n_frames : 0.0;
+  }
+};
+
+
+/**
+ * @brief Runs a DAG of models as a pipeline.
+ *
+ * Stages are models connected by edges from an output of one stage to an
+ * input of another stage. Stage inputs without an incoming edge form the
+ * pipeline inputs, stage outputs without an outgoing edge form the pipeline
+ * outputs, both named `<stage>/<input or output name>`.
+ *
+ * Every stage runs on its own thread and processes a different frame, so
+ * throughput is bound by the slowest stage instead of the sum of all
+ * stages. Frames are passed through the stages in topological order via
+ * bounded queues, which block `enqueue` once the pipeline is full. Tensors
+ * are moved between stages without copies or map lookups.
+ *
+ * Models are referenced, not owned, and must outlive the pipeline.
+ */
+class ModelPipeline {
+
+ public:
+  /**
+   * @brief Creates an empty pipeline.
+   *
+   * @param[in]  queue_capacity  maximum number of frames waiting per stage
+   */
+  explicit ModelPipeline(const int queue_capacity = 4)
+      : queue_capacity_(std::max(1, queue_capacity)) {}
+
+  ModelPipeline(const ModelPipeline&) = delete;
+  ModelPipeline& operator=(const ModelPipeline&) = delete;
+
+  /**
+   * @brief Processes all pending frames and stops the stage threads.
+   */
+  ~ModelPipeline() {
+    stop();
+  }
+
+  /**
+   * @brief Adds a stage.
+   *
+   * @param[in]  name   stage name
+   * @param[in]  model  loaded model
+   */
+  void addStage(const std::string& name, const Model& model) {
+
+    if (isRunning())
+      throw std::runtime_error("Cannot add stage to running pipeline");
+    if (!model.isLoaded())
+      throw std::runtime_error("Cannot add stage '" + name +
+                               "', model is not loaded");
+    if (stage_indices_.count(name) > 0)
+      throw std::runtime_error("Pipeline stage '" + name + "' already exists");
+
+    stage_indices_[name] = stages_.size();
+    stages_.emplace_back(new Stage);
+    stages_.back()->name = name;
+    stages_.back()->model = &model;
+    stages_.back()->input_sources.resize(model.nInputs(), {-1, -1});
+  }
+
+  /**
+   * @brief Connects an output of one stage to an input of another stage.
+   *
+   * @param[in]  from_stage   producing stage name
+   * @param[in]  output_name  output name of producing stage's model
+   * @param[in]  to_stage     consuming stage name
+   * @param[in]  input_name   input name of consuming stage's model
+   */
+  void connect(const std::string& from_stage, const std::string& output_name,
+               const std::string& to_stage, const std::string& input_name) {
+
+    if (isRunning())
+      throw std::runtime_error("Cannot connect stages of running pipeline");
+
+    const int from = stageIndex(from_stage);
+    const int to = stageIndex(to_stage);
+    const int output = stages_[from]->model->outputIndex(output_name);
+    const int input = stages_[to]->model->inputIndex(input_name);
+    if (from == to)
+      throw std::runtime_error("Cannot connect stage '" + from_stage +
+                               "' to itself");
+    if (stages_[to]->input_sources[input].first >= 0)
+      throw std::runtime_error("Input '" + to_stage + "/" + input_name +
+                               "' is already connected");
+
+    stages_[to]->input_sources[input] = {from, output};
+  }
+
+  /**
+   * @brief Validates the DAG and starts the stage threads.
+   */
+  void start() {
+
+    if (isRunning()) throw std::runtime_error("Pipeline is already running");
+    if (stages_.empty()) throw std::runtime_error("Pipeline has no stages");
+
+    // sort stages topologically, keeping insertion order where possible
+    const int n_stages = stages_.size();
+    std::vector<int> n_dependencies(n_stages, 0);
+    for (int s = 0; s < n_stages; s++)
+      for (const auto& source : stages_[s]->input_sources)
+        if (source.first >= 0) n_dependencies[s]++;
+    order_.clear();
+    std::vector<bool> sorted(n_stages, false);
+    while (order_.size() < n_stages) {
+      int next = -1;
+      for (int s = 0; s < n_stages && next < 0; s++)
+        if (!sorted[s] && n_dependencies[s] == 0) next = s;
+      if (next < 0)
+        throw std::runtime_error("Pipeline stages contain a cycle");
+      sorted[next] = true;
+      order_.push_back(next);
+      for (int s = 0; s < n_stages; s++)
+        for (const auto& source : stages_[s]->input_sources)
+          if (source.first == next) n_dependencies[s]--;
+    }
+
+    // assign frame slots: pipeline inputs first, then all stage outputs
+    input_names_.clear();
+    output_names_.clear();
+    output_slots_.clear();
+    int n_slots = 0;
+    std::vector<int> first_output_slot(n_stages);
+    for (const int s : order_) {
+      Stage& stage = *stages_[s];
+      const auto& names = stage.model->inputNames();
+      stage.input_slots.assign(names.size(), -1);
+      for (int k = 0; k < names.size(); k++) {
+        if (stage.input_sources[k].first >= 0) continue;
+        input_names_.push_back(stage.name + "/" + names[k]);
+        stage.input_slots[k] = n_slots++;
+      }
+    }
+    for (const int s : order_) {
+      first_output_slot[s] = n_slots;
+      n_slots += stages_[s]->model->nOutputs();
+    }
+    n_slots_ = n_slots;
+
+    // resolve edges to slots, the last consumer of a slot may move from it
+    std::vector<int> n_consumers(n_slots_, 0);
+    for (const int s : order_) {
+      Stage& stage = *stages_[s];
+      stage.output_slots.resize(stage.model->nOutputs());
+      for (int k = 0; k < stage.output_slots.size(); k++)
+        stage.output_slots[k] = first_output_slot[s] + k;
+      for (int k = 0; k < stage.input_sources.size(); k++) {
+        const auto& source = stage.input_sources[k];
+        if (source.first >= 0)
+          stage.input_slots[k] =
+            first_output_slot[source.first] + source.second;
+        n_consumers[stage.input_slots[k]]++;
+      }
+    }
+    for (const int s : order_) {
+      Stage& stage = *stages_[s];
+      stage.move_inputs.resize(stage.input_slots.size());
+      for (int k = 0; k < stage.input_slots.size(); k++)
+        stage.move_inputs[k] = (--n_consumers[stage.input_slots[k]] == 0);
+    }
+    for (const int s : order_) {
+      const Stage& stage = *stages_[s];
+      const auto& names = stage.model->outputNames();
+      for (int k = 0; k < names.size(); k++) {
+        bool consumed = false;
+        for (const auto& other : stages_)
+          for (const int slot : other->input_slots)
+            if (slot == stage.output_slots[k]) consumed = true;
+        if (consumed) continue;
+        output_names_.push_back(stage.name + "/" + names[k]);
+        output_slots_.push_back(stage.output_slots[k]);
+      }
+    }
+
+    // start stage threads
+    for (auto& stage : stages_) {
+      stage->queue.reset(queue_capacity_);
+      stage->stats = StageStats();
+    }
+    running_ = true;
+    for (int p = 0; p < order_.size(); p++)
+      stages_[order_[p]]->thread =
+        std::thread(&ModelPipeline::runStage, this, p);
+  }
+
+  /**
+   * @brief Processes all pending frames and stops the stage threads.
+   *
+   * The pipeline can be modified and started again afterwards.
+   */
+  void stop() {
+
+    if (!running_.exchange(false)) return;
+    stages_[order_.front()]->queue.close();
+    for (const int s : order_) stages_[s]->thread.join();
+  }
+
+  /**
+   * @brief Checks whether the stage threads are running.
+   *
+   * @return  true   if pipeline is running
+   * @return  false  if pipeline is not running
+   */
+  bool isRunning() const {
+    return running_;
+  }
+
+  /**
+   * @brief Queues a frame, blocking while the first stage's queue is full.
+   *
+   * Input tensors are expected in the order given by `inputNames`. The
+   * future holds the output tensors in the order given by `outputNames`.
+   * Errors of any stage are passed on as exceptions through the future.
+   * Frames can be queued from multiple threads and concurrently with `stop`,
+   * but not while the pipeline is being modified or started.
+   *
+   * @param[in]  input_tensors                     input tensors
+   *
+   * @return  std::future<std::vector<tf::Tensor>> output tensors
+   */
+  std::future<std::vector<tf::Tensor>> enqueue(
+    std::vector<tf::Tensor> input_tensors) {
+
+    if (!running_)
+      throw std::runtime_error("Cannot queue frame, pipeline is not running");
+    if (input_tensors.size() != input_names_.size()) {
+      throw std::runtime_error(
+        "Pipeline has " + std::to_string(input_names_.size()) +
+        " inputs, but " + std::to_string(input_tensors.size()) +
+        " input tensors were given");
+    }
+
+    Frame frame;
+    frame.slots = std::move(input_tensors);
+    frame.slots.resize(n_slots_);
+    std::future<std::vector<tf::Tensor>> future = frame.promise.get_future();
+    if (!stages_[order_.front()]->queue.push(std::move(frame)))
+      throw std::runtime_error("Cannot queue frame, pipeline is stopping");
+
+    return future;
+  }
+
+  /**
+   * @brief Runs a frame through the pipeline and waits for the result.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(std::vector<tf::Tensor> input_tensors) {
+
+    return enqueue(std::move(input_tensors)).get();
+  }
+
+  /**
+   * @brief Returns the pipeline input names, available after `start`.
+   *
+   * @return  std::vector<std::string>  input names
+   */
+  const std::vector<std::string>& inputNames() const {
+    return input_names_;
+  }
+
+  /**
+   * @brief Returns the pipeline output names, available after `start`.
+   *
+   * @return  std::vector<std::string>  output names
+   */
+  const std::vector<std::string>& outputNames() const {
+    return output_names_;
+  }
+
+  /**
+   * @brief Returns the stage names in the order stages were added.
+   *
+   * @return  std::vector<std::string>  stage names
+   */
+  std::vector<std::string> stageNames() const {
+
+    std::vector<std::string> names;
+    for (const auto& stage : stages_) names.push_back(stage->name);
+
+    return names;
+  }
+
+  /**
+   * @brief Returns the number of stages.
+   *
+   * @return  int  number of stages
+   */
+  int nStages() const {
+    return stages_.size();
+  }
+
+  /**
+   * @brief Returns the timing statistics of a stage.
+   *
+   * @param[in]  name        stage name
+   *
+   * @return  StageStats     stage statistics
+   */
+  StageStats stageStats(const std::string& name) const {
+
+    const Stage& stage = *stages_[stageIndex(name)];
+    std::lock_guard<std::mutex> lock(stage.stats_mutex);
+    StageStats stats = stage.stats;
+    stats.queue_size = stage.queue.size();
+
+    return stats;
+  }
+
+ protected:
+  /**
+   * @brief Frame passed through the pipeline.
+   */
+  struct Frame {
+
+    /**
+     * @brief pipeline inputs followed by the outputs of all stages
+     */
+    std::vector<tf::Tensor> slots;
+
+    /**
+     * @brief error of the first failed stage
+     */
+    std::exception_ptr error;
+
+    /**
+     * @brief promise for pipeline outputs
+     */
+    std::promise<std::vector<tf::Tensor>> promise;
+  };
+
+  /**
+   * @brief Bounded blocking queue of frames.
+   */
+  class FrameQueue {
+
+   public:
+    /**
+     * @brief Empties and reopens the queue.
+     *
+     * @param[in]  capacity  maximum number of queued frames
+     */
+    void reset(const int capacity) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      frames_.clear();
+      capacity_ = capacity;
+      closed_ = false;
+    }
+
+    /**
+     * @brief Queues a frame, blocking while the queue is full.
+     *
+     * @param[in]  frame  frame
+     *
+     * @return  true      if frame was queued
+     * @return  false     if queue is closed
+     */
+    bool push(Frame&& frame) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_full_.wait(
+        lock, [this] { return closed_ || frames_.size() < capacity_; });
+      if (closed_) return false;
+      frames_.push_back(std::move(frame));
+      lock.unlock();
+      not_empty_.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Takes the next frame, blocking while the queue is empty.
+     *
+     * @param[out]  frame  frame
+     *
+     * @return  true       if a frame was taken
+     * @return  false      if queue is closed and empty
+     */
+    bool pop(Frame& frame) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this] { return closed_ || !frames_.empty(); });
+      if (frames_.empty()) return false;
+      frame = std::move(frames_.front());
+      frames_.pop_front();
+      lock.unlock();
+      not_full_.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Closes the queue, queued frames can still be taken.
+     */
+    void close() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+      }
+      not_empty_.notify_all();
+      not_full_.notify_all();
+    }
+
+    /**
+     * @brief Returns the number of queued frames.
+     *
+     * @return  int  number of queued frames
+     */
+    int size() const {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return frames_.size();
+    }
+
+   protected:
+    /**
+     * @brief queued frames
+     */
+    std::deque<Frame> frames_;
+
+    /**
+     * @brief maximum number of queued frames
+     */
+    size_t capacity_ = 1;
+
+    /**
+     * @brief whether the queue is closed
+     */
+    bool closed_ = false;
+
+    /**
+     * @brief mutex guarding the queue
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief condition variable signaling queued frames
+     */
+    std::condition_variable not_empty_;
+
+    /**
+     * @brief condition variable signaling free space
+     */
+    std::condition_variable not_full_;
+  };
+
+  /**
+   * @brief Pipeline stage.
+   */
+  struct Stage {
+
+    /**
+     * @brief stage name
+     */
+    std::string name;
+
+    /**
+     * @brief model run by the stage
+     */
+    const Model* model = nullptr;
+
+    /**
+     * @brief producing stage and output index per model input (-1: pipeline
+     * input)
+     */
+    std::vector<std::pair<int, int>> input_sources;
+
+    /**
+     * @brief frame slot per model input
+     */
+    std::vector<int> input_slots;
+
+    /**
+     * @brief whether the stage is the last consumer of an input slot
+     */
+    std::vector<bool> move_inputs;
+
+    /**
+     * @brief frame slot per model output
+     */
+    std::vector<int> output_slots;
+
+    /**
+     * @brief queue of frames waiting for the stage
+     */
+    FrameQueue queue;
+
+    /**
+     * @brief stage thread
+     */
+    std::thread thread;
+
+    /**
+     * @brief timing statistics
+     */
+    StageStats stats;
+
+    /**
+     * @brief mutex guarding the statistics
+     */
+    mutable std::mutex stats_mutex;
+  };
+
+  /**
+   * @brief Determines the index of a stage.
+   *
+   * @param[in]  name  stage name
+   *
+   * @return  int      stage index
+   */
+  int stageIndex(const std::string& name) const {
+
+    const auto it = stage_indices_.find(name);
+    if (it == stage_indices_.end())
+      throw std::runtime_error("Unknown pipeline stage '" + name + "'");
+
+    return it->second;
+  }
+
+  /**
+   * @brief Processes frames of a stage until its queue is closed.
+   *
+   * @param[in]  position  position of the stage in topological order
+   */
+  void runStage(const int position) {
+
+    Stage& stage = *stages_[order_[position]];
+    FrameQueue* next = (position + 1 < order_.size())
+                         ? &stages_[order_[position + 1]]->queue
+                         : nullptr;
+
+    // reused across frames to avoid reallocations
+    std::vector<tf::Tensor> inputs(stage.input_slots.size());
+    std::vector<tf::Tensor> outputs;
+
+    Frame frame;
+    while (stage.queue.pop(frame)) {
+
+      if (!frame.error) {
+        try {
+          for (int k = 0; k < inputs.size(); k++) {
+            tf::Tensor& slot = frame.slots[stage.input_slots[k]];
+            inputs[k] = stage.move_inputs[k] ? std::move(slot) : slot;
+          }
+          const auto t0 = std::chrono::steady_clock::now();
+          stage.model->run(inputs, outputs);
+          const double ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count();
+          for (int k = 0; k < outputs.size(); k++)
+            frame.slots[stage.output_slots[k]] = std::move(outputs[k]);
+          for (auto& input : inputs) input = tf::Tensor();
+          std::lock_guard<std::mutex> lock(stage.stats_mutex);
+          stage.stats.n_frames++;
+          stage.stats.total_ms += ms;
+          stage.stats.max_ms = std::max(stage.stats.max_ms, ms);
+        } catch (...) {
+          frame.error = std::current_exception();
+        }
+      }
+
+      if (next) {
+        next->push(std::move(frame));
+      } else if (frame.error) {
+        frame.promise.set_exception(frame.error);
+      } else {
+        std::vector<tf::Tensor> pipeline_outputs;
+        pipeline_outputs.reserve(output_slots_.size());
+        for (const int slot : output_slots_)
+          pipeline_outputs.push_back(std::move(frame.slots[slot]));
+        frame.promise.set_value(std::move(pipeline_outputs));
+      }
+    }
+
+    if (next) next->close();
+  }
+
+ protected:
+  /**
+   * @brief stages in the order they were added
+   */
+  std::vector<std::unique_ptr<Stage>> stages_;
+
+  /**
+   * @brief stage indices by name
+   */
+  std::unordered_map<std::string, int> stage_indices_;
+
+  /**
+   * @brief stage indices in topological order
+   */
+  std::vector<int> order_;
+
+  /**
+   * @brief pipeline input names
+   */
+  std::vector<std::string> input_names_;
+
+  /**
+   * @brief pipeline output names
+   */
+  std::vector<std::string> output_names_;
+
+  /**
+   * @brief frame slot per pipeline output
+   */
+  std::vector<int> output_slots_;
+
+  /**
+   * @brief number of slots per frame
+   */
+  int n_slots_ = 0;
+
+  /**
+   * @brief maximum number of frames waiting per stage
+   */
+  int queue_capacity_ = 4;
+
+  /**
+   * @brief whether the stage threads are running, read by `enqueue` from
+   * producer threads
+   */
+  std::atomic<bool> running_{false};
+};
+
+
+}  // namespace tensorflow_cpp
@@ -0,0 +1,292 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ModelRegistry class
+ */
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/thread_pool.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+/**
+ * @brief Registry of named models, loaded concurrently or on first use.
+ *
+ * Models added to the registry are loaded in parallel on a thread pool, which
+ * overlaps the disk I/O and session creation of multi-model processes. Models
+ * added as lazy are only loaded once they are first requested via `get`, or
+ * once `loadAll` is called. All methods are thread-safe.
+ */
+class ModelRegistry {
+
+ public:
+  /**
+   * @brief Creates an empty model registry.
+   *
+   * @param[in]  n_threads  number of threads loading models (0: number of
+   * cores)
+   */
+  explicit ModelRegistry(const int n_threads = 0) : pool_(n_threads) {}
+
+  ModelRegistry(const ModelRegistry&) = delete;
+  ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+  /**
+   * @brief Adds a model to the registry.
+   *
+   * Unless `lazy` is set, loading of the model starts immediately in the
+   * background.
+   *
+   * @param[in]  name        name to register the model under
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  warmup      run dummy inference to warmup
+   * @param[in]  lazy        defer loading until first use
+   */
+  void add(const std::string& name, const std::string& model_path,
+           const SessionConfig& config = SessionConfig(),
+           const bool warmup = false, const bool lazy = false) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(name) > 0)
+      throw std::runtime_error("Model '" + name + "' is already registered");
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->model_path = model_path;
+    entry->config = config;
+    entry->warmup = warmup;
+    entry->model.reset(new Model());
+    if (!lazy) startLoading(*entry);
+    entries_[name] = std::move(entry);
+  }
+
+  /**
+   * @brief Returns a registered model, waiting for it to be loaded.
+   *
+   * Lazy models are loaded on first call. Errors during loading are rethrown.
+   *
+   * @param[in]  name     registered model name
+   *
+   * @return  Model&      loaded model
+   */
+  Model& get(const std::string& name) {
+
+    std::shared_future<void> loading;
+    Model* model;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Entry& entry = findEntry(name);
+      startLoading(entry);
+      loading = entry.loading;
+      model = entry.model.get();
+    }
+    loading.get();
+
+    return *model;
+  }
+
+  /**
+   * @brief Returns a registered model, waiting for it to be loaded.
+   *
+   * See `get`.
+   *
+   * @param[in]  name     registered model name
+   *
+   * @return  Model&      loaded model
+   */
+  Model& operator[](const std::string& name) {
+    return get(name);
+  }
+
+  /**
+   * @brief Starts loading all models that have not been loaded yet.
+   */
+  void loadAll() {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) startLoading(*entry.second);
+  }
+
+  /**
+   * @brief Waits until all models that have started loading are loaded.
+   *
+   * Errors during loading are rethrown.
+   */
+  void wait() {
+
+    std::vector<std::shared_future<void>> loadings;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& entry : entries_)
+        if (entry.second->loading.valid())
+          loadings.push_back(entry.second->loading);
+    }
+    for (auto& loading : loadings) loading.get();
+  }
+
+  /**
+   * @brief Checks whether a model is registered.
+   *
+   * @param[in]  name   model name
+   *
+   * @return  true      if model is registered
+   * @return  false     if model is not registered
+   */
+  bool contains(const std::string& name) const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(name) > 0;
+  }
+
+  /**
+   * @brief Checks whether a registered model has finished loading
+   * successfully, without waiting.
+   *
+   * @param[in]  name   registered model name
+   *
+   * @return  true      if model is loaded
+   * @return  false     if model is not loaded (yet)
+   */
+  bool isLoaded(const std::string& name) const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(name);
+    if (it == entries_.end() || !it->second->loading.valid()) return false;
+    const auto& loading = it->second->loading;
+    if (loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return false;
+
+    return it->second->model->isLoaded();
+  }
+
+  /**
+   * @brief Returns the names of all registered models.
+   *
+   * @return  std::vector<std::string>  model names
+   */
+  std::vector<std::string> names() const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto& entry : entries_) names.push_back(entry.first);
+
+    return names;
+  }
+
+ protected:
+  /**
+   * @brief Registered model and its loading state.
+   */
+  struct Entry {
+
+    /**
+     * @brief SavedModel or FrozenGraph path
+     */
+    std::string model_path;
+
+    /**
+     * @brief session configuration
+     */
+    SessionConfig config;
+
+    /**
+     * @brief whether to run dummy inference to warmup
+     */
+    bool warmup = false;
+
+    /**
+     * @brief model, fixed in memory while loading in the background
+     */
+    std::unique_ptr<Model> model;
+
+    /**
+     * @brief completion of loading, invalid if loading has not started
+     */
+    std::shared_future<void> loading;
+  };
+
+  /**
+   * @brief Finds a registered model, expects the mutex to be held.
+   *
+   * @param[in]  name   registered model name
+   *
+   * @return  Entry&    registry entry
+   */
+  Entry& findEntry(const std::string& name) {
+
+    const auto it = entries_.find(name);
+    if (it == entries_.end())
+      throw std::runtime_error("Model '" + name + "' is not registered");
+
+    return *it->second;
+  }
+
+  /**
+   * @brief Starts loading a model, if not already started; expects the mutex
+   * to be held.
+   *
+   * @param[in]  entry  registry entry
+   */
+  void startLoading(Entry& entry) {
+
+    if (entry.loading.valid()) return;
+    Entry* e = &entry;
+    auto load = [e]() {
+      e->model->loadModel(e->model_path, e->config, e->warmup);
+    };
+    entry.loading = pool_.submit(load).share();
+  }
+
+ protected:
+  /**
+   * @brief registered models by name
+   */
+  std::map<std::string, std::unique_ptr<Entry>> entries_;
+
+  /**
+   * @brief mutex guarding the registry entries
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * @brief thread pool loading models, destroyed first to finish loading
+   */
+  ThreadPool pool_;
+};
+
+
+}  // namespace tensorflow_cpp
@@ -0,0 +1,220 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Observer interface for monitoring model runs
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/framework/tensor_shape.h>
+#include <tensorflow/core/platform/status.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Information about a single session run passed to observers.
+ */
+struct RunEvent {
+
+  /**
+   * @brief model name, see `Model::name`
+   */
+  std::string model_name;
+
+  /**
+   * @brief shapes of the fed input tensors
+   */
+  std::vector<tf::TensorShape> input_shapes;
+
+  /**
+   * @brief size of dimension 0 of the first input (-1: unknown)
+   */
+  tf::int64 batch_size = -1;
+
+  /**
+   * @brief wall time of the session run, only set after the run [ms]
+   */
+  double duration_ms = 0;
+
+  /**
+   * @brief whether the session run succeeded, only set after the run
+   */
+  bool ok = true;
+
+  /**
+   * @brief error message if the session run failed
+   */
+  std::string error;
+};
+
+
+/**
+ * @brief Interface for observing model runs, e.g. for tracing or metrics.
+ *
+ * Hooks are invoked around every session run, i.e. once per call and once
+ * per micro-batch, see `Model::setMicroBatching`. Hooks may be invoked
+ * concurrently from multiple threads and must not throw.
+ */
+class ModelObserver {
+
+ public:
+  virtual ~ModelObserver() {}
+
+  /**
+   * @brief Called right before the session is run.
+   *
+   * @param[in]  event  run event without timing and status
+   */
+  virtual void preRun(const RunEvent& /*event*/) {}
+
+  /**
+   * @brief Called right after the session was run.
+   *
+   * @param[in]  event  run event
+   */
+  virtual void postRun(const RunEvent& /*event*/) {}
+};
+
+
+/**
+ * @brief Notifies an observer about a session run.
+ *
+ * Does nothing, not even collecting input shapes, if no observer is set.
+ */
+class ObserverScope {
+
+ public:
+  /**
+   * @brief clock used for all time measurements
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Prepares notifying an observer.
+   *
+   * @param[in]  observer    observer to notify, may be nullptr
+   * @param[in]  model_name  model name
+   */
+  ObserverScope(ModelObserver* observer, const std::string& model_name)
+      : observer_(observer) {
+
+    if (observer_) event_.model_name = model_name;
+  }
+
+  ObserverScope(const ObserverScope&) = delete;
+  ObserverScope& operator=(const ObserverScope&) = delete;
+
+  /**
+   * @brief Notifies the observer that the session is about to be run.
+   *
+   * @param[in]  input_tensors  input tensors
+   */
+  void begin(const std::vector<tf::Tensor>& input_tensors) {
+
+    if (!observer_) return;
+    for (const auto& tensor : input_tensors) addInput(tensor);
+    notifyBegin();
+  }
+
+  /**
+   * @brief Notifies the observer that the session is about to be run.
+   *
+   * @param[in]  input_nodes  input tensors by node name
+   */
+  void begin(
+    const std::vector<std::pair<std::string, tf::Tensor>>& input_nodes) {
+
+    if (!observer_) return;
+    for (const auto& input : input_nodes) addInput(input.second);
+    notifyBegin();
+  }
+
+  /**
+   * @brief Notifies the observer that the session was run.
+   *
+   * @param[in]  status  status returned by the session
+   */
+  void end(const tf::Status& status) {
+
+    if (!observer_) return;
+    event_.duration_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start_)
+        .count();
+    event_.ok = status.ok();
+    if (!status.ok()) event_.error = status.ToString();
+    observer_->postRun(event_);
+  }
+
+ protected:
+  /**
+   * @brief Adds an input tensor to the event.
+   *
+   * @param[in]  tensor  input tensor
+   */
+  void addInput(const tf::Tensor& tensor) {
+
+    if (event_.input_shapes.empty() && tensor.dims() > 0)
+      event_.batch_size = tensor.dim_size(0);
+    event_.input_shapes.push_back(tensor.shape());
+  }
+
+  /**
+   * @brief Notifies the observer and starts timing the run.
+   */
+  void notifyBegin() {
+
+    observer_->preRun(event_);
+    start_ = Clock::now();
+  }
+
+ protected:
+  /**
+   * @brief observer to notify
+   */
+  ModelObserver* observer_;
+
+  /**
+   * @brief event passed to the observer
+   */
+  RunEvent event_;
+
+  /**
+   * @brief session run start
+   */
+  Clock::time_point start_;
+};
+
+
+}  // namespace tensorflow_cpp
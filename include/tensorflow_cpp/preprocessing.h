@@ -0,0 +1,219 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utility functions for fused image preprocessing
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Configuration of image preprocessing.
+ *
+ * Each output channel `k` is computed from source channel `channel_order[k]`
+ * as `(src * scale - mean[k]) / stddev[k]`.
+ */
+struct PreprocessingConfig {
+
+  /**
+   * @brief factor applied to raw pixel values, e.g. 1/255
+   */
+  float scale = 1.0f;
+
+  /**
+   * @brief per-channel mean subtracted after scaling (empty: 0)
+   */
+  std::vector<float> mean;
+
+  /**
+   * @brief per-channel standard deviation divided by after scaling (empty: 1)
+   */
+  std::vector<float> stddev;
+
+  /**
+   * @brief source channel of each output channel, e.g. {2, 1, 0} for BGR to
+   * RGB (empty: keep order)
+   */
+  std::vector<int> channel_order;
+
+  /**
+   * @brief whether to output CHW instead of HWC layout
+   */
+  bool channels_first = false;
+};
+
+
+/**
+ * @brief Converts an 8-bit HWC image in a single pass.
+ *
+ * Type conversion, normalization, channel reordering and layout transposition
+ * are fused into simple inner loops over contiguous memory, which compilers
+ * vectorize.
+ *
+ * @param[in]   src         HWC image
+ * @param[in]   height      image height
+ * @param[in]   width       image width
+ * @param[in]   channels    number of channels
+ * @param[in]   row_stride  bytes per image row (0: `width * channels`)
+ * @param[in]   config      preprocessing configuration
+ * @param[out]  dst         `height * width * channels` output elements
+ */
+template <typename T>
+inline void preprocessImage(const uint8_t* src, const int height,
+                            const int width, const int channels,
+                            const int row_stride,
+                            const PreprocessingConfig& config, T* dst) {
+
+  const int src_row_stride = row_stride > 0 ? row_stride : width * channels;
+  if ((!config.mean.empty() && config.mean.size() != channels) ||
+      (!config.stddev.empty() && config.stddev.size() != channels) ||
+      (!config.channel_order.empty() &&
+       config.channel_order.size() != channels))
+    throw std::runtime_error(
+      "Preprocessing configuration does not match number of channels (" +
+      std::to_string(channels) + ")");
+
+  // fold scale, mean and stddev into a single multiply-add per channel
+  std::vector<float> factors(channels), offsets(channels);
+  std::vector<int> order(channels);
+  bool keeps_order = true;
+  for (int k = 0; k < channels; k++) {
+    const float mean = config.mean.empty() ? 0.0f : config.mean[k];
+    const float stddev = config.stddev.empty() ? 1.0f : config.stddev[k];
+    factors[k] = config.scale / stddev;
+    offsets[k] = -mean / stddev;
+    order[k] = config.channel_order.empty() ? k : config.channel_order[k];
+    if (order[k] < 0 || order[k] >= channels)
+      throw std::runtime_error("Invalid channel order in preprocessing");
+    keeps_order = keeps_order && order[k] == k;
+  }
+
+  const int row_size = width * channels;
+  if (config.channels_first) {
+    // strided reads per channel, contiguous writes per channel plane
+    for (int y = 0; y < height; y++) {
+      const uint8_t* src_row = src + y * src_row_stride;
+      for (int k = 0; k < channels; k++) {
+        const uint8_t* src_channel = src_row + order[k];
+        T* dst_row = dst + (k * height + y) * width;
+        const float factor = factors[k];
+        const float offset = offsets[k];
+        for (int x = 0; x < width; x++)
+          dst_row[x] =
+            static_cast<T>(src_channel[x * channels] * factor + offset);
+      }
+    }
+  } else {
+    // expand per-channel coefficients to a full row, once
+    std::vector<float> row_factors(row_size), row_offsets(row_size);
+    std::vector<int> row_order(row_size);
+    for (int i = 0; i < row_size; i++) {
+      const int k = i % channels;
+      row_factors[i] = factors[k];
+      row_offsets[i] = offsets[k];
+      row_order[i] = i - k + order[k];
+    }
+    const float* f = row_factors.data();
+    const float* o = row_offsets.data();
+    for (int y = 0; y < height; y++) {
+      const uint8_t* src_row = src + y * src_row_stride;
+      T* dst_row = dst + y * row_size;
+      if (keeps_order) {
+        for (int i = 0; i < row_size; i++)
+          dst_row[i] = static_cast<T>(src_row[i] * f[i] + o[i]);
+      } else {
+        for (int i = 0; i < row_size; i++)
+          dst_row[i] = static_cast<T>(src_row[row_order[i]] * f[i] + o[i]);
+      }
+    }
+  }
+}
+
+
+/**
+ * @brief Converts an 8-bit HWC image into (part of) a tensor in a single pass.
+ *
+ * See `preprocessImage`. Supports float, double, half and bfloat16 tensors.
+ *
+ * @param[in]   src         HWC image
+ * @param[in]   height      image height
+ * @param[in]   width       image width
+ * @param[in]   channels    number of channels
+ * @param[in]   row_stride  bytes per image row (0: `width * channels`)
+ * @param[in]   config      preprocessing configuration
+ * @param[out]  dst         tensor to write to
+ * @param[in]   offset      index of first tensor element to write, e.g. to
+ * fill one element of a batch
+ */
+inline void preprocessImage(const uint8_t* src, const int height,
+                            const int width, const int channels,
+                            const int row_stride,
+                            const PreprocessingConfig& config, tf::Tensor& dst,
+                            const tf::int64 offset = 0) {
+
+  if (offset + static_cast<tf::int64>(height) * width * channels >
+      dst.NumElements())
+    throw std::runtime_error("Preprocessed image does not fit into tensor of "
+                             "shape " +
+                             dst.shape().DebugString());
+
+  switch (dst.dtype()) {
+    case tf::DT_FLOAT:
+      preprocessImage(src, height, width, channels, row_stride, config,
+                      dst.unaligned_flat<float>().data() + offset);
+      break;
+    case tf::DT_DOUBLE:
+      preprocessImage(src, height, width, channels, row_stride, config,
+                      dst.unaligned_flat<double>().data() + offset);
+      break;
+    case tf::DT_HALF:
+      preprocessImage(src, height, width, channels, row_stride, config,
+                      dst.unaligned_flat<Eigen::half>().data() + offset);
+      break;
+    case tf::DT_BFLOAT16:
+      preprocessImage(src, height, width, channels, row_stride, config,
+                      dst.unaligned_flat<tf::bfloat16>().data() + offset);
+      break;
+    default:
+      throw std::runtime_error("Preprocessing into tensor of datatype " +
+                               tf::DataTypeString(dst.dtype()) +
+                               " is not supported");
+  }
+}
+
+
+}  // namespace tensorflow_cpp
@@ -0,0 +1,394 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utilities for profiling model inference
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <tensorflow/core/public/session.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Accumulated timing statistics of profiled model calls.
+ *
+ * Each call's wall time is split into the time spent preparing inputs in the
+ * wrapper, the time spent in the TensorFlow session, and the time spent
+ * building outputs in the wrapper.
+ */
+struct ProfilingStats {
+
+  /**
+   * @brief number of profiled calls
+   */
+  long n_calls = 0;
+
+  /**
+   * @brief number of calls for which a full trace was collected
+   */
+  long n_traced_calls = 0;
+
+  /**
+   * @brief accumulated wall time of all calls [ms]
+   */
+  double total_ms = 0;
+
+  /**
+   * @brief accumulated time preparing inputs before running the session [ms]
+   */
+  double input_ms = 0;
+
+  /**
+   * @brief accumulated time spent running the session [ms]
+   */
+  double session_ms = 0;
+
+  /**
+   * @brief accumulated time building outputs after running the session [ms]
+   */
+  double output_ms = 0;
+
+  /**
+   * @brief wall time of the slowest call [ms]
+   */
+  double max_ms = 0;
+
+  /**
+   * @brief upper bounds of latency histogram buckets [ms], the last bucket
+   * counts all slower calls
+   */
+  std::vector<double> histogram_bounds_ms = {0.1, 0.2, 0.5, 1,   2,   5,  10,
+                                             20,  50,  100, 200, 500, 1000};
+
+  /**
+   * @brief number of calls per latency histogram bucket
+   */
+  std::vector<long> histogram_counts =
+    std::vector<long>(histogram_bounds_ms.size() + 1, 0);
+
+  /**
+   * @brief run metadata including step stats of the last traced call
+   */
+  tf::RunMetadata last_run_metadata;
+
+  /**
+   * @brief Returns the mean wall time per call.
+   *
+   * @return  double  mean wall time [ms]
+   */
+  double meanMs() const {
+    return (n_calls > 0) ? total_ms / n_calls : 0.0;
+  }
+
+  /**
+   * @brief Returns the accumulated time spent in the wrapper itself.
+   *
+   * @return  double  wrapper overhead [ms]
+   */
+  double wrapperMs() const {
+    return input_ms + output_ms;
+  }
+};
+
+
+/**
+ * @brief Collects timing statistics of model calls.
+ *
+ * Thread-safe, calls may be recorded concurrently.
+ */
+class Profiler {
+
+ public:
+  /**
+   * @brief clock used for all time measurements
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Creates a profiler.
+   *
+   * @param[in]  trace_every_n  collect a full trace every n-th call (0: never)
+   */
+  explicit Profiler(const int trace_every_n = 0)
+      : trace_every_n_(trace_every_n) {}
+
+  /**
+   * @brief Determines whether the next call should be fully traced.
+   *
+   * @return  true   if the next call should be traced
+   * @return  false  otherwise
+   */
+  bool nextCallTraced() {
+
+    if (trace_every_n_ <= 0) return false;
+
+    return (call_counter_++ % trace_every_n_) == 0;
+  }
+
+  /**
+   * @brief Records the timing of a call.
+   *
+   * @param[in]  start          call start
+   * @param[in]  session_start  session run start
+   * @param[in]  session_end    session run end
+   * @param[in]  end            call end
+   * @param[in]  run_metadata   run metadata if call was traced, else nullptr
+   */
+  void record(const Clock::time_point& start,
+              const Clock::time_point& session_start,
+              const Clock::time_point& session_end,
+              const Clock::time_point& end,
+              const tf::RunMetadata* run_metadata = nullptr) {
+
+    using Ms = std::chrono::duration<double, std::milli>;
+    const double total_ms = Ms(end - start).count();
+    const int bucket =
+      std::lower_bound(stats_.histogram_bounds_ms.begin(),
+                       stats_.histogram_bounds_ms.end(), total_ms) -
+      stats_.histogram_bounds_ms.begin();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.n_calls++;
+    stats_.total_ms += total_ms;
+    stats_.input_ms += Ms(session_start - start).count();
+    stats_.session_ms += Ms(session_end - session_start).count();
+    stats_.output_ms += Ms(end - session_end).count();
+    stats_.max_ms = std::max(stats_.max_ms, total_ms);
+    stats_.histogram_counts[bucket]++;
+    if (run_metadata) {
+      stats_.n_traced_calls++;
+      stats_.last_run_metadata = *run_metadata;
+    }
+  }
+
+  /**
+   * @brief Returns a snapshot of the accumulated statistics.
+   *
+   * @return  ProfilingStats  statistics
+   */
+  ProfilingStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  /**
+   * @brief Resets the accumulated statistics.
+   */
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = ProfilingStats();
+  }
+
+ protected:
+  /**
+   * @brief collect a full trace every n-th call (0: never)
+   */
+  const int trace_every_n_;
+
+  /**
+   * @brief number of calls seen so far, used for trace sampling
+   */
+  std::atomic<long> call_counter_{0};
+
+  /**
+   * @brief accumulated statistics
+   */
+  ProfilingStats stats_;
+
+  /**
+   * @brief mutex guarding the statistics
+   */
+  mutable std::mutex mutex_;
+};
+
+
+/**
+ * @brief Measures a single model call and records it on destruction.
+ *
+ * Does nothing if constructed without profiler, so that it can be placed on
+ * the hot path unconditionally.
+ */
+class ProfilingScope {
+
+ public:
+  /**
+   * @brief Starts measuring a call.
+   *
+   * @param[in]  profiler  profiler to record to, may be nullptr
+   */
+  explicit ProfilingScope(Profiler* profiler) : profiler_(profiler) {
+
+    if (!profiler_) return;
+    start_ = Profiler::Clock::now();
+    if (profiler_->nextCallTraced()) run_metadata_.reset(new tf::RunMetadata());
+  }
+
+  /**
+   * @brief Records the call, unless the session was never run successfully.
+   */
+  ~ProfilingScope() {
+
+    if (!profiler_ || !session_ended_) return;
+    profiler_->record(start_, session_start_, session_end_,
+                      Profiler::Clock::now(), run_metadata_.get());
+  }
+
+  ProfilingScope(const ProfilingScope&) = delete;
+  ProfilingScope& operator=(const ProfilingScope&) = delete;
+
+  /**
+   * @brief Marks the start of running the session.
+   */
+  void beginSession() {
+    if (profiler_) session_start_ = Profiler::Clock::now();
+  }
+
+  /**
+   * @brief Marks the end of running the session.
+   *
+   * @param[in]  status  status returned by the session
+   */
+  void endSession(const tf::Status& status) {
+
+    if (!profiler_) return;
+    session_end_ = Profiler::Clock::now();
+    session_ended_ = status.ok();
+  }
+
+  /**
+   * @brief Returns the run metadata to collect, if the call is traced.
+   *
+   * @return  tf::RunMetadata*  run metadata, nullptr if call is not traced
+   */
+  tf::RunMetadata* runMetadata() {
+    return run_metadata_.get();
+  }
+
+  /**
+   * @brief Records the call as untraced, e.g. if the session run cannot
+   * collect run metadata.
+   */
+  void dropTrace() {
+    run_metadata_.reset();
+  }
+
+ protected:
+  /**
+   * @brief profiler to record to
+   */
+  Profiler* profiler_;
+
+  /**
+   * @brief call start
+   */
+  Profiler::Clock::time_point start_;
+
+  /**
+   * @brief session run start
+   */
+  Profiler::Clock::time_point session_start_;
+
+  /**
+   * @brief session run end
+   */
+  Profiler::Clock::time_point session_end_;
+
+  /**
+   * @brief whether the session was run successfully
+   */
+  bool session_ended_ = false;
+
+  /**
+   * @brief run metadata, only allocated if call is traced
+   */
+  std::unique_ptr<tf::RunMetadata> run_metadata_;
+};
+
+
+/**
+ * @brief Converts the step stats of a traced run to Chrome trace format.
+ *
+ * The resulting JSON can be inspected in `chrome://tracing` or Perfetto, with
+ * one process row per device.
+ *
+ * @param[in]  step_stats   step stats from `tf::RunMetadata`
+ *
+ * @return  std::string     Chrome trace JSON
+ */
+inline std::string stepStatsToChromeTrace(const tf::StepStats& step_stats) {
+
+  auto escape = [](const std::string& str) {
+    std::string escaped;
+    for (const char c : str) {
+      if (c == '"' || c == '\\') escaped += '\\';
+      if (c == '\n') {
+        escaped += "\\n";
+        continue;
+      }
+      escaped += c;
+    }
+    return escaped;
+  };
+
+  std::stringstream ss;
+  ss << "{\"traceEvents\":[";
+  bool first = true;
+  for (int pid = 0; pid < step_stats.dev_stats_size(); pid++) {
+    const auto& dev_stats = step_stats.dev_stats(pid);
+    ss << (first ? "" : ",") << "{\"name\":\"process_name\",\"ph\":\"M\","
+       << "\"pid\":" << pid << ",\"args\":{\"name\":\""
+       << escape(dev_stats.device()) << "\"}}";
+    first = false;
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      ss << ",{\"name\":\"" << escape(node_stats.node_name())
+         << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":0"
+         << ",\"ts\":" << node_stats.all_start_micros()
+         << ",\"dur\":" << node_stats.all_end_rel_micros()
+         << ",\"args\":{\"label\":\"" << escape(node_stats.timeline_label())
+         << "\"}}";
+    }
+  }
+  ss << "]}";
+
+  return ss.str();
+}
+
+
+}  // namespace tensorflow_cpp
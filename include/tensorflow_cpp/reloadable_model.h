@@ -0,0 +1,271 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ReloadableModel class
+ */
+
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/thread_pool.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Model wrapper supporting hot-reloads without interrupting inference.
+ *
+ * A new model version is loaded and warmed up on a background thread and then
+ * swapped in atomically. Every call runs on a snapshot of the current model,
+ * so calls in flight during a swap finish on the old version, which is freed
+ * once the last of them returns. All methods are thread-safe.
+ *
+ * Callables and signatures belong to a single model version; obtain them from
+ * a snapshot via `model` and run them on the same snapshot.
+ */
+class ReloadableModel {
+
+ public:
+  /**
+   * @brief Creates an empty reloadable model.
+   */
+  ReloadableModel() {}
+
+  /**
+   * @brief Creates a reloadable model by loading and warming up a model.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  profile     warmup profile
+   */
+  ReloadableModel(const std::string& model_path,
+                  const SessionConfig& config = SessionConfig(),
+                  const WarmupProfile& profile = WarmupProfile()) {
+
+    loadModel(model_path, config, profile);
+  }
+
+  ReloadableModel(const ReloadableModel&) = delete;
+  ReloadableModel& operator=(const ReloadableModel&) = delete;
+
+  /**
+   * @brief Loads and warms up a model on the calling thread and swaps it in.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  config      session configuration
+   * @param[in]  profile     warmup profile
+   */
+  void loadModel(const std::string& model_path,
+                 const SessionConfig& config = SessionConfig(),
+                 const WarmupProfile& profile = WarmupProfile()) {
+
+    std::shared_ptr<const Model> model =
+      std::make_shared<Model>(model_path, config, profile);
+    std::atomic_store(&model_, model);
+    version_++;
+  }
+
+  /**
+   * @brief Loads and warms up a model in the background and swaps it in.
+   *
+   * The current model keeps serving calls until the new one is ready.
+   * Reloads are processed in order. If loading fails, the current model is
+   * kept and the error is passed on as exception through the future.
+   *
+   * @param[in]  model_path         SavedModel or FrozenGraph path
+   * @param[in]  config             session configuration
+   * @param[in]  profile            warmup profile
+   *
+   * @return  std::future<void>    completion of the reload
+   */
+  std::future<void> reload(const std::string& model_path,
+                           const SessionConfig& config = SessionConfig(),
+                           const WarmupProfile& profile = WarmupProfile()) {
+
+    return reload_pool_.submit([this, model_path, config, profile]() {
+      loadModel(model_path, config, profile);
+    });
+  }
+
+  /**
+   * @brief Returns a snapshot of the current model.
+   *
+   * The snapshot stays valid, even if a newer version is swapped in.
+   *
+   * @return  std::shared_ptr<const Model>  current model (nullptr if not
+   * loaded)
+   */
+  std::shared_ptr<const Model> model() const {
+    return std::atomic_load(&model_);
+  }
+
+  /**
+   * @brief Returns the number of model versions swapped in so far.
+   *
+   * @return  int  model version
+   */
+  int version() const {
+    return version_;
+  }
+
+  /**
+   * @brief Checks whether a model is loaded already.
+   *
+   * @return  true   if model is loaded
+   * @return  false  if model is not loaded
+   */
+  bool isLoaded() const {
+
+    const auto current = model();
+    return current && current->isLoaded();
+  }
+
+  /**
+   * @brief Runs the current model.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    const std::vector<std::pair<std::string, tf::Tensor>>& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    return (*loadedModel())(inputs, output_names);
+  }
+
+  /**
+   * @brief Runs the current model, taking ownership of the inputs.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    std::vector<std::pair<std::string, tf::Tensor>>&& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    return (*loadedModel())(std::move(inputs), output_names);
+  }
+
+  /**
+   * @brief Runs the current model.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    return (*loadedModel())(input_tensors);
+  }
+
+  /**
+   * @brief Runs the current model, taking ownership of the input tensors.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    std::vector<tf::Tensor>&& input_tensors) const {
+
+    return (*loadedModel())(std::move(input_tensors));
+  }
+
+  /**
+   * @brief Runs the current model.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  input_tensor  input tensor
+   *
+   * @return  tf::Tensor       output tensor
+   */
+  tf::Tensor operator()(const tf::Tensor& input_tensor) const {
+
+    return (*loadedModel())(input_tensor);
+  }
+
+ protected:
+  /**
+   * @brief Returns a snapshot of the current model, which has to be loaded.
+   *
+   * @return  std::shared_ptr<const Model>  current model
+   */
+  std::shared_ptr<const Model> loadedModel() const {
+
+    auto current = model();
+    if (!current)
+      throw std::runtime_error("Cannot run reloadable model before loading");
+
+    return current;
+  }
+
+ protected:
+  /**
+   * @brief current model, accessed atomically
+   */
+  std::shared_ptr<const Model> model_;
+
+  /**
+   * @brief number of model versions swapped in so far
+   */
+  std::atomic<int> version_{0};
+
+  /**
+   * @brief thread loading new model versions, destroyed first to finish
+   * pending reloads
+   */
+  ThreadPool reload_pool_{1};
+};
+
+
+}  // namespace tensorflow_cpp
@@ -0,0 +1,538 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ReplicatedModel class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/framework/tensor_util.h>
+#include <tensorflow/core/util/batch_util.h>
+#include <tensorflow_cpp/device_utils.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/thread_pool.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Policy for dispatching calls to model replicas.
+ */
+enum class DispatchPolicy {
+  /**
+   * @brief cycle through replicas
+   */
+  kRoundRobin,
+  /**
+   * @brief pick the replica with the fewest calls in flight
+   */
+  kLeastLoaded
+};
+
+
+/**
+ * @brief Model replicated across multiple devices, e.g. one replica per GPU.
+ *
+ * Every replica is a separate session whose graph is placed on its device via
+ * `SessionConfig::device`. All replicas share the same `visible_device_list`,
+ * since TensorFlow only supports a single GPU configuration per process.
+ * Calls are dispatched to a single replica according to a `DispatchPolicy`;
+ * optionally, batched inputs are split across all replicas instead, see
+ * `setBatchSplitting`. Calls may be issued concurrently from multiple threads.
+ */
+class ReplicatedModel {
+
+ public:
+  /**
+   * @brief Creates an empty replicated model.
+   */
+  ReplicatedModel() {}
+
+  /**
+   * @brief Creates a replicated model by loading one replica per device.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  devices     devices, e.g. "/device:GPU:1" (empty: all GPUs)
+   * @param[in]  config      session configuration shared by all replicas
+   * @param[in]  policy      dispatch policy
+   * @param[in]  profile     warmup profile applied to every replica
+   */
+  ReplicatedModel(const std::string& model_path,
+                  const std::vector<std::string>& devices = {},
+                  const SessionConfig& config = SessionConfig(),
+                  const DispatchPolicy policy = DispatchPolicy::kRoundRobin,
+                  const WarmupProfile& profile = WarmupProfile()) {
+
+    policy_ = policy;
+    loadModel(model_path, devices, config, profile);
+  }
+
+  ReplicatedModel(const ReplicatedModel&) = delete;
+  ReplicatedModel& operator=(const ReplicatedModel&) = delete;
+
+  /**
+   * @brief Loads one replica per device.
+   *
+   * If no devices are given, one replica is placed on every GPU visible to
+   * the process, falling back to a single replica with automatic placement
+   * if there is none. Not thread-safe with respect to running calls.
+   *
+   * @param[in]  model_path  SavedModel or FrozenGraph path
+   * @param[in]  devices     devices, e.g. "/device:GPU:1" (empty: all GPUs)
+   * @param[in]  config      session configuration shared by all replicas
+   * @param[in]  profile     warmup profile applied to every replica
+   */
+  void loadModel(const std::string& model_path,
+                 const std::vector<std::string>& devices = {},
+                 const SessionConfig& config = SessionConfig(),
+                 const WarmupProfile& profile = WarmupProfile()) {
+
+    std::vector<std::string> replica_devices = devices;
+    if (replica_devices.empty()) replica_devices = visibleGpus(config);
+    if (replica_devices.empty()) replica_devices.push_back("");
+
+    split_pool_.reset();
+    replicas_.clear();
+    for (const std::string& device : replica_devices) {
+      SessionConfig replica_config = config;
+      replica_config.device = device;
+      std::unique_ptr<Replica> replica(new Replica());
+      replica->device = device;
+      replica->model.reset(new Model(model_path, replica_config, profile));
+      replicas_.push_back(std::move(replica));
+    }
+    if (replicas_.size() > 1)
+      split_pool_.reset(new ThreadPool(replicas_.size() - 1));
+  }
+
+  /**
+   * @brief Checks whether the model is loaded already.
+   *
+   * @return  true   if model is loaded
+   * @return  false  if model is not loaded
+   */
+  bool isLoaded() const {
+
+    if (replicas_.empty()) return false;
+    for (const auto& replica : replicas_)
+      if (!replica->model->isLoaded()) return false;
+
+    return true;
+  }
+
+  /**
+   * @brief Sets the dispatch policy.
+   *
+   * @param[in]  policy  dispatch policy
+   */
+  void setDispatchPolicy(const DispatchPolicy policy) {
+    policy_ = policy;
+  }
+
+  /**
+   * @brief Enables or disables splitting batched inputs across all replicas.
+   *
+   * If enabled, positional inputs are split along their first (batch)
+   * dimension into one contiguous part per replica, run in parallel and
+   * concatenated again. Inputs with fewer samples than replicas use as many
+   * replicas as there are samples.
+   *
+   * @param[in]  split  whether to split batches
+   */
+  void setBatchSplitting(const bool split) {
+    split_batches_ = split;
+  }
+
+  /**
+   * @brief Runs the model on a single replica.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    const std::vector<std::pair<std::string, tf::Tensor>>& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    InFlight replica(*this, selectReplica());
+    return (*replica.model())(inputs, output_names);
+  }
+
+  /**
+   * @brief Runs the model on a single replica, taking ownership of the
+   * inputs.
+   *
+   * See `Model::operator()`.
+   *
+   * @param[in]  inputs                                       inputs by name
+   * @param[in]  output_names                                 output names
+   *
+   * @return  std::unordered_map<std::string, tf::Tensor>     outputs by name
+   */
+  std::unordered_map<std::string, tf::Tensor> operator()(
+    std::vector<std::pair<std::string, tf::Tensor>>&& inputs,
+    const std::vector<std::string>& output_names) const {
+
+    InFlight replica(*this, selectReplica());
+    return (*replica.model())(std::move(inputs), output_names);
+  }
+
+  /**
+   * @brief Runs the model on a single replica or split across all replicas.
+   *
+   * See `Model::operator()` and `setBatchSplitting`.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    if (isSplit(input_tensors)) return runSplit(input_tensors);
+    InFlight replica(*this, selectReplica());
+
+    return (*replica.model())(input_tensors);
+  }
+
+  /**
+   * @brief Runs the model on a single replica or split across all replicas,
+   * taking ownership of the input tensors.
+   *
+   * See `Model::operator()` and `setBatchSplitting`.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> operator()(
+    std::vector<tf::Tensor>&& input_tensors) const {
+
+    if (isSplit(input_tensors)) return runSplit(input_tensors);
+    InFlight replica(*this, selectReplica());
+
+    return (*replica.model())(std::move(input_tensors));
+  }
+
+  /**
+   * @brief Runs the model on a single replica or split across all replicas.
+   *
+   * See `Model::operator()` and `setBatchSplitting`.
+   *
+   * @param[in]  input_tensor  input tensor
+   *
+   * @return  tf::Tensor       output tensor
+   */
+  tf::Tensor operator()(const tf::Tensor& input_tensor) const {
+
+    if (isSplit({input_tensor})) return runSplit({input_tensor})[0];
+    InFlight replica(*this, selectReplica());
+
+    return (*replica.model())(input_tensor);
+  }
+
+  /**
+   * @brief Returns the number of replicas.
+   *
+   * @return  int  number of replicas
+   */
+  int nReplicas() const {
+    return replicas_.size();
+  }
+
+  /**
+   * @brief Returns a replica.
+   *
+   * @param[in]  idx           replica index
+   *
+   * @return  const Model&     replica
+   */
+  const Model& replica(const int idx) const {
+    return *replicas_.at(idx)->model;
+  }
+
+  /**
+   * @brief Returns the devices of all replicas.
+   *
+   * @return  std::vector<std::string>  devices (empty: automatic placement)
+   */
+  std::vector<std::string> devices() const {
+
+    std::vector<std::string> names;
+    for (const auto& replica : replicas_) names.push_back(replica->device);
+
+    return names;
+  }
+
+  /**
+   * @brief Returns the number of calls currently running on a replica.
+   *
+   * @param[in]  idx  replica index
+   *
+   * @return  int     number of calls in flight
+   */
+  int nInFlight(const int idx) const {
+    return replicas_.at(idx)->in_flight;
+  }
+
+ protected:
+  /**
+   * @brief Single model replica.
+   */
+  struct Replica {
+
+    /**
+     * @brief model placed on device
+     */
+    std::unique_ptr<Model> model;
+
+    /**
+     * @brief device (empty: automatic placement)
+     */
+    std::string device;
+
+    /**
+     * @brief number of calls in flight
+     */
+    std::atomic<int> in_flight{0};
+  };
+
+  /**
+   * @brief Counts a call as in flight on a replica for its lifetime.
+   */
+  class InFlight {
+
+   public:
+    InFlight(const ReplicatedModel& model, const size_t idx)
+        : replica_(*model.replicas_[idx]) {
+      replica_.in_flight++;
+    }
+
+    ~InFlight() {
+      replica_.in_flight--;
+    }
+
+    InFlight(const InFlight&) = delete;
+    InFlight& operator=(const InFlight&) = delete;
+
+    const Model* model() const {
+      return replica_.model.get();
+    }
+
+   protected:
+    Replica& replica_;
+  };
+
+  /**
+   * @brief Determines all GPUs visible to sessions with a configuration.
+   *
+   * @param[in]  config                    session configuration
+   *
+   * @return  std::vector<std::string>     GPU device names
+   */
+  static std::vector<std::string> visibleGpus(const SessionConfig& config) {
+
+    std::unique_ptr<tf::Session> session(createSession(config));
+    std::vector<std::string> gpus;
+    for (int k = 0;; k++) {
+      const std::string gpu = getSessionGpuDeviceName(session.get(), k);
+      if (gpu.empty()) break;
+      gpus.push_back(gpu);
+    }
+
+    return gpus;
+  }
+
+  /**
+   * @brief Selects the replica for the next call according to the policy.
+   *
+   * @return  size_t  replica index
+   */
+  size_t selectReplica() const {
+
+    if (replicas_.empty())
+      throw std::runtime_error("Cannot run ReplicatedModel before loading it");
+    const size_t n = replicas_.size();
+    const size_t offset = next_replica_++ % n;
+    if (policy_ == DispatchPolicy::kRoundRobin) return offset;
+
+    // start at a rotating offset to spread ties evenly
+    size_t best = offset;
+    int best_load = std::numeric_limits<int>::max();
+    for (size_t k = 0; k < n; k++) {
+      const size_t idx = (offset + k) % n;
+      const int load = replicas_[idx]->in_flight;
+      if (load < best_load) {
+        best = idx;
+        best_load = load;
+      }
+    }
+
+    return best;
+  }
+
+  /**
+   * @brief Checks whether inputs are split across replicas.
+   *
+   * @param[in]  input_tensors  input tensors
+   *
+   * @return  true              if inputs are split
+   * @return  false             otherwise
+   */
+  bool isSplit(const std::vector<tf::Tensor>& input_tensors) const {
+
+    return split_batches_ && replicas_.size() > 1 && !input_tensors.empty() &&
+           input_tensors[0].dims() > 0 && input_tensors[0].dim_size(0) > 1;
+  }
+
+  /**
+   * @brief Runs inputs split across replicas, see `setBatchSplitting`.
+   *
+   * @param[in]  input_tensors            input tensors
+   *
+   * @return  std::vector<tf::Tensor>     output tensors
+   */
+  std::vector<tf::Tensor> runSplit(
+    const std::vector<tf::Tensor>& input_tensors) const {
+
+    const tf::int64 batch_size = input_tensors[0].dim_size(0);
+    for (const auto& input : input_tensors) {
+      if (input.dims() == 0 || input.dim_size(0) != batch_size)
+        throw std::runtime_error(
+          "Cannot split inputs with differing batch dimensions");
+    }
+
+    // split evenly, the first parts take one extra sample each
+    const tf::int64 n_parts =
+      std::min<tf::int64>(replicas_.size(), batch_size);
+    const tf::int64 min_part_size = batch_size / n_parts;
+    const tf::int64 n_larger_parts = batch_size % n_parts;
+    auto partStart = [min_part_size, n_larger_parts](const tf::int64 idx) {
+      return idx * min_part_size + std::min(idx, n_larger_parts);
+    };
+
+    // slices share the input buffers, unaligned slices are copied
+    auto runPart = [this, &input_tensors, partStart](const tf::int64 idx) {
+      const tf::int64 start = partStart(idx);
+      const tf::int64 end = partStart(idx + 1);
+      std::vector<tf::Tensor> part;
+      for (const auto& input : input_tensors) {
+        tf::Tensor slice = input.Slice(start, end);
+        part.push_back(slice.IsAligned() ? slice : tf::tensor::DeepCopy(slice));
+      }
+      InFlight replica(*this, idx);
+      return (*replica.model())(part);
+    };
+
+    // first part runs on the calling thread
+    std::vector<std::future<std::vector<tf::Tensor>>> parts;
+    std::vector<std::vector<tf::Tensor>> part_outputs(n_parts);
+    try {
+      for (tf::int64 idx = 1; idx < n_parts; idx++)
+        parts.push_back(
+          split_pool_->submit([runPart, idx]() { return runPart(idx); }));
+      part_outputs[0] = runPart(0);
+      for (tf::int64 idx = 1; idx < n_parts; idx++)
+        part_outputs[idx] = parts[idx - 1].get();
+    } catch (...) {
+      // pending parts reference the inputs
+      for (auto& pending : parts)
+        if (pending.valid()) pending.wait();
+      throw;
+    }
+
+    // concatenate part outputs along the batch dimension
+    std::vector<tf::Tensor> output_tensors;
+    for (const auto& output : part_outputs[0]) {
+      if (output.dims() == 0 || output.dim_size(0) != partStart(1))
+        throw std::runtime_error("Cannot split model with unbatched outputs");
+      tf::TensorShape shape = output.shape();
+      shape.set_dim(0, batch_size);
+      output_tensors.emplace_back(output.dtype(), shape);
+    }
+    for (tf::int64 idx = 0; idx < n_parts; idx++) {
+      const tf::int64 start = partStart(idx);
+      const tf::int64 size = partStart(idx + 1) - start;
+      for (int k = 0; k < output_tensors.size(); k++) {
+        tf::Status status = tf::batch_util::CopyContiguousSlices(
+          part_outputs[idx][k], 0, start, size, &output_tensors[k]);
+        if (!status.ok())
+          throw std::runtime_error("Failed to collect split outputs: " +
+                                   status.ToString());
+      }
+    }
+
+    return output_tensors;
+  }
+
+ protected:
+  /**
+   * @brief model replicas, one per device
+   */
+  std::vector<std::unique_ptr<Replica>> replicas_;
+
+  /**
+   * @brief dispatch policy
+   */
+  DispatchPolicy policy_ = DispatchPolicy::kRoundRobin;
+
+  /**
+   * @brief whether to split batched inputs across replicas
+   */
+  bool split_batches_ = false;
+
+  /**
+   * @brief counter for round-robin dispatch and tie-breaking
+   */
+  mutable std::atomic<size_t> next_replica_{0};
+
+  /**
+   * @brief threads running all but the first part of split batches,
+   * destroyed first to finish pending parts
+   */
+  std::unique_ptr<ThreadPool> split_pool_;
+};
+
+
+}  // namespace tensorflow_cpp
@@ -30,11 +30,20 @@ SOFTWARE.
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <tensorflow/cc/saved_model/constants.h>
 #include <tensorflow/cc/saved_model/loader.h>
+#include <tensorflow/cc/saved_model/reader.h>
 #include <tensorflow/cc/saved_model/tag_constants.h>
+#include <tensorflow/core/framework/tensor.pb.h>
+#include <tensorflow/core/lib/io/record_reader.h>
+#include <tensorflow/core/platform/path.h>
+#include <tensorflow_cpp/graph_utils.h>
 #include <tensorflow_cpp/utils.h>
 
 
@@ -44,26 +53,113 @@ namespace tensorflow_cpp {
 namespace tf = tensorflow;
 
 
+/**
+ * @brief Loads a TensorFlow SavedModel from a directory into a new session,
+ * placing all nodes without explicit placement on a device.
+ *
+ * `tf::LoadSavedModel` offers no control over placement, so the MetaGraph is
+ * placed, restored and initialized manually, including assets.
+ *
+ * @param[in]  dir                        SavedModel directory
+ * @param[in]  config                     session configuration
+ * @param[in]  device                     device name, e.g. "/device:GPU:1"
+ *
+ * @return  tf::SavedModelBundleLite      SavedModel
+ */
+inline tf::SavedModelBundleLite loadSavedModelOnDevice(
+  const std::string& dir, const SessionConfig& config,
+  const std::string& device) {
+
+  tf::MetaGraphDef meta_graph_def;
+  tf::Status status = tf::ReadMetaGraphDefFromSavedModel(
+    dir, {tf::kSavedModelTagServe}, &meta_graph_def);
+  if (!status.ok())
+    throw std::runtime_error("Failed to load SavedModel: " + status.ToString());
+  placeGraphOnDevice(meta_graph_def.mutable_graph_def(), device);
+  std::unique_ptr<tf::Session> session(createSession(config));
+  loadGraphIntoSession(session.get(), meta_graph_def.graph_def());
+
+  // asset file paths are fed to restore and init ops
+  std::vector<std::pair<std::string, tf::Tensor>> assets;
+  for (const auto& asset : meta_graph_def.asset_file_def()) {
+    tf::Tensor path(tf::DT_STRING, tf::TensorShape({}));
+    path.scalar<tf::tstring>()() = tf::io::JoinPath(
+      dir, tf::kSavedModelAssetsDirectory, asset.filename());
+    assets.emplace_back(asset.tensor_info().name(), path);
+  }
+
+  // restore variables, if any
+  const tf::SaverDef& saver_def = meta_graph_def.saver_def();
+  const std::string variables_path = tf::io::JoinPath(
+    dir, tf::kSavedModelVariablesDirectory, tf::kSavedModelVariablesFilename);
+  if (!saver_def.restore_op_name().empty() &&
+      tf::Env::Default()->FileExists(variables_path + ".index").ok()) {
+    tf::Tensor path(tf::DT_STRING, tf::TensorShape({}));
+    path.scalar<tf::tstring>()() = variables_path;
+    std::vector<std::pair<std::string, tf::Tensor>> inputs = assets;
+    inputs.emplace_back(saver_def.filename_tensor_name(), path);
+    status = session->Run(config.run_options, inputs, {},
+                          {saver_def.restore_op_name()}, nullptr, nullptr);
+    if (!status.ok())
+      throw std::runtime_error("Failed to restore SavedModel variables: " +
+                               status.ToString());
+  }
+
+  // run init op, stored as signature (TF2) or collection (TF1)
+  std::string init_op;
+  const auto& signatures = meta_graph_def.signature_def();
+  const auto& collections = meta_graph_def.collection_def();
+  const auto init_signature =
+    signatures.find(tf::kSavedModelInitOpSignatureKey);
+  if (init_signature != signatures.end()) {
+    const auto& outputs = init_signature->second.outputs();
+    const auto output = outputs.find(tf::kSavedModelInitOpSignatureKey);
+    if (output != outputs.end()) init_op = output->second.name();
+  } else {
+    for (const std::string key :
+         {tf::kSavedModelMainOpKey, tf::kSavedModelLegacyInitOpKey}) {
+      const auto collection = collections.find(key);
+      if (collection != collections.end() &&
+          collection->second.node_list().value_size() > 0) {
+        init_op = collection->second.node_list().value(0);
+        break;
+      }
+    }
+  }
+  if (!init_op.empty()) {
+    status = session->Run(config.run_options, assets, {}, {init_op}, nullptr,
+                          nullptr);
+    if (!status.ok())
+      throw std::runtime_error("Failed to initialize SavedModel: " +
+                               status.ToString());
+  }
+
+  return tf::SavedModelBundleLite(
+    std::move(session), std::move(*meta_graph_def.mutable_signature_def()));
+}
+
+
 /**
  * @brief Loads a TensorFlow SavedModel from a directory into a new session.
  *
- * @param[in]  dir                              SavedModel directory
- * @param[in]  allow_growth                     dynamically grow GPU usage
- * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
- * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * If `config.device` is set, all nodes without explicit placement are placed
+ * on that device, see `loadSavedModelOnDevice`.
  *
- * @return  tf::SavedModelBundleLite            SavedModel
+ * @param[in]  dir                        SavedModel directory
+ * @param[in]  config                     session configuration
+ *
+ * @return  tf::SavedModelBundleLite      SavedModel
  */
-inline tf::SavedModelBundleLite loadSavedModel(
-  const std::string& dir, const bool allow_growth = true,
-  const double per_process_gpu_memory_fraction = 0,
-  const std::string& visible_device_list = "") {
+inline tf::SavedModelBundleLite loadSavedModel(const std::string& dir,
+                                               const SessionConfig& config) {
+
+  if (!config.device.empty())
+    return loadSavedModelOnDevice(dir, config, config.device);
 
   tf::SavedModelBundleLite saved_model;
-  tf::SessionOptions session_options = makeSessionOptions(
-    allow_growth, per_process_gpu_memory_fraction, visible_device_list);
+  tf::SessionOptions session_options = makeSessionOptions(config);
   tf::Status status =
-    tf::LoadSavedModel(session_options, tf::RunOptions(), dir,
+    tf::LoadSavedModel(session_options, config.run_options, dir,
                        {tf::kSavedModelTagServe}, &saved_model);
   if (!status.ok())
     throw std::runtime_error("Failed to load SavedModel: " + status.ToString());
@@ -79,16 +175,47 @@ inline tf::SavedModelBundleLite loadSavedModel(
  * @param[in]  allow_growth                     dynamically grow GPU usage
  * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
  * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
+ *
+ * @return  tf::SavedModelBundleLite            SavedModel
+ */
+inline tf::SavedModelBundleLite loadSavedModel(
+  const std::string& dir, const bool allow_growth = true,
+  const double per_process_gpu_memory_fraction = 0,
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
+
+  return loadSavedModel(
+    dir, makeSessionConfig(allow_growth, per_process_gpu_memory_fraction,
+                           visible_device_list, intra_op_parallelism_threads,
+                           inter_op_parallelism_threads));
+}
+
+
+/**
+ * @brief Loads a TensorFlow SavedModel from a directory into a new session.
+ *
+ * @param[in]  dir                              SavedModel directory
+ * @param[in]  allow_growth                     dynamically grow GPU usage
+ * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+ * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
  *
  * @return  tf::Session*                        session
  */
 inline tf::Session* loadSavedModelIntoNewSession(
   const std::string& dir, const bool allow_growth = true,
   const double per_process_gpu_memory_fraction = 0,
-  const std::string& visible_device_list = "") {
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
 
   tf::SavedModelBundleLite saved_model = loadSavedModel(
-    dir, allow_growth, per_process_gpu_memory_fraction, visible_device_list);
+    dir, allow_growth, per_process_gpu_memory_fraction, visible_device_list,
+    intra_op_parallelism_threads, inter_op_parallelism_threads);
   tf::Session* session = saved_model.GetSession();
 
   return session;
@@ -109,6 +236,75 @@ inline tf::Session* getSessionFromSavedModel(
 }
 
 
+/**
+ * @brief Looks up a signature input or output by layer name.
+ *
+ * Inputs take precedence over outputs of the same name.
+ *
+ * @param[in]  signature_def          signature
+ * @param[in]  layer_name             layer name
+ *
+ * @return  const tf::TensorInfo*     tensor info (nullptr if not found)
+ */
+inline const tf::TensorInfo* findSavedModelTensorInfo(
+  const tf::SignatureDef& signature_def, const std::string& layer_name) {
+
+  const auto input = signature_def.inputs().find(layer_name);
+  if (input != signature_def.inputs().end()) return &input->second;
+  const auto output = signature_def.outputs().find(layer_name);
+  if (output != signature_def.outputs().end()) return &output->second;
+
+  return nullptr;
+}
+
+
+/**
+ * @brief Looks up a signature input or output by node name.
+ *
+ * Inputs take precedence over outputs of the same node.
+ *
+ * @param[in]   signature_def         signature
+ * @param[in]   node_name             node name
+ * @param[out]  layer_name            layer name, if found (optional)
+ *
+ * @return  const tf::TensorInfo*     tensor info (nullptr if not found)
+ */
+inline const tf::TensorInfo* findSavedModelTensorInfoByNode(
+  const tf::SignatureDef& signature_def, const std::string& node_name,
+  std::string* layer_name = nullptr) {
+
+  for (const auto* tensors :
+       {&signature_def.inputs(), &signature_def.outputs()}) {
+    for (const auto& tensor : *tensors) {
+      if (tensor.second.name() == node_name) {
+        if (layer_name) *layer_name = tensor.first;
+        return &tensor.second;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+
+/**
+ * @brief Determines the shape of a signature input or output.
+ *
+ * @param[in]  info              tensor info
+ *
+ * @return  std::vector<int>     shape
+ */
+inline std::vector<int> getTensorInfoShape(const tf::TensorInfo& info) {
+
+  std::vector<int> shape;
+  const auto& shape_proto = info.tensor_shape();
+  for (int d = 0; d < shape_proto.dim_size(); d++)
+    shape.push_back(shape_proto.dim(d).size());
+
+  return shape;
+}
+
+
 /**
  * @brief Determines the node name from a SavedModel layer name.
  *
@@ -125,22 +321,10 @@ inline std::string getSavedModelNodeByLayerName(
   const tf::SavedModelBundleLite& saved_model, const std::string& layer_name,
   const std::string& signature = "serving_default") {
 
-  std::string node_name;
-  const tf::SignatureDef& model_def = saved_model.GetSignatures().at(signature);
-  auto inputs = model_def.inputs();
-  auto outputs = model_def.outputs();
-  auto& nodes = inputs;
-  nodes.insert(outputs.begin(), outputs.end());
-  for (const auto& node : nodes) {
-    const std::string& key = node.first;
-    const tf::TensorInfo& info = node.second;
-    if (key == layer_name) {
-      node_name = info.name();
-      break;
-    }
-  }
+  const tf::TensorInfo* info = findSavedModelTensorInfo(
+    saved_model.GetSignatures().at(signature), layer_name);
 
-  return node_name;
+  return info ? info->name() : "";
 }
 
 
@@ -161,19 +345,8 @@ inline std::string getSavedModelLayerByNodeName(
   const std::string& signature = "serving_default") {
 
   std::string layer_name;
-  const tf::SignatureDef& model_def = saved_model.GetSignatures().at(signature);
-  auto inputs = model_def.inputs();
-  auto outputs = model_def.outputs();
-  auto& nodes = inputs;
-  nodes.insert(outputs.begin(), outputs.end());
-  for (const auto& node : nodes) {
-    const std::string& key = node.first;
-    const tf::TensorInfo& info = node.second;
-    if (info.name() == node_name) {
-      layer_name = key;
-      break;
-    }
-  }
+  findSavedModelTensorInfoByNode(saved_model.GetSignatures().at(signature),
+                                 node_name, &layer_name);
 
   return layer_name;
 }
@@ -274,24 +447,10 @@ inline std::vector<int> getSavedModelNodeShape(
   const tf::SavedModelBundleLite& saved_model, const std::string& node_name,
   const std::string& signature = "serving_default") {
 
-  std::vector<int> node_shape;
-  const tf::SignatureDef& model_def = saved_model.GetSignatures().at(signature);
-  auto inputs = model_def.inputs();
-  auto outputs = model_def.outputs();
-  auto& nodes = inputs;
-  nodes.insert(outputs.begin(), outputs.end());
-  for (const auto& node : nodes) {
-    const std::string& key = node.first;
-    const tf::TensorInfo& info = node.second;
-    if (info.name() == node_name) {
-      const auto& shape = info.tensor_shape();
-      for (int d = 0; d < shape.dim_size(); d++)
-        node_shape.push_back(shape.dim(d).size());
-      break;
-    }
-  }
+  const tf::TensorInfo* info = findSavedModelTensorInfoByNode(
+    saved_model.GetSignatures().at(signature), node_name);
 
-  return node_shape;
+  return info ? getTensorInfoShape(*info) : std::vector<int>();
 }
 
 
@@ -308,22 +467,102 @@ inline tf::DataType getSavedModelNodeType(
   const tf::SavedModelBundleLite& saved_model, const std::string& node_name,
   const std::string& signature = "serving_default") {
 
-  tf::DataType type = tf::DT_INVALID;
-  const tf::SignatureDef& model_def = saved_model.GetSignatures().at(signature);
-  auto inputs = model_def.inputs();
-  auto outputs = model_def.outputs();
-  auto& nodes = inputs;
-  nodes.insert(outputs.begin(), outputs.end());
-  for (const auto& node : nodes) {
-    const std::string& key = node.first;
-    const tf::TensorInfo& info = node.second;
-    if (info.name() == node_name) {
-      type = info.dtype();
+  const tf::TensorInfo* info = findSavedModelTensorInfoByNode(
+    saved_model.GetSignatures().at(signature), node_name);
+
+  return info ? info->dtype() : tf::DT_INVALID;
+}
+
+
+/**
+ * @brief Extracts all length-delimited values of a field from a serialized
+ * protobuf message.
+ *
+ * Allows to read messages whose proto definitions are not part of TensorFlow,
+ * e.g. TensorFlow Serving's `PredictionLog`.
+ *
+ * @param[in]  message                   serialized message
+ * @param[in]  field_number              field number
+ *
+ * @return  std::vector<std::string>     serialized field values
+ */
+inline std::vector<std::string> getProtoFieldValues(const std::string& message,
+                                                    const int field_number) {
+
+  std::vector<std::string> values;
+  google::protobuf::io::CodedInputStream stream(
+    reinterpret_cast<const uint8_t*>(message.data()), message.size());
+  uint32_t tag;
+  while ((tag = stream.ReadTag()) != 0) {
+    const bool is_field = (tag >> 3) == field_number;
+    const bool is_length_delimited = (tag & 7) == 2;
+    if (is_field && is_length_delimited) {
+      uint32_t length;
+      std::string value;
+      if (!stream.ReadVarint32(&length) || !stream.ReadString(&value, length))
+        break;
+      values.push_back(value);
+    } else if (!stream.SkipField(tag)) {
       break;
     }
   }
 
-  return type;
+  return values;
+}
+
+
+/**
+ * @brief Loads the warmup requests stored with a SavedModel.
+ *
+ * Warmup requests are stored as TFRecord of TensorFlow Serving
+ * `PredictionLog`s in `assets.extra/tf_serving_warmup_requests`. Only predict
+ * requests are supported, other request types are ignored.
+ *
+ * @param[in]  dir   SavedModel directory
+ *
+ * @return  std::vector<std::vector<std::pair<std::string, tf::Tensor>>>
+ * inputs by layer name, per request; empty if there are no warmup requests
+ */
+inline std::vector<std::vector<std::pair<std::string, tf::Tensor>>>
+  loadSavedModelWarmupRequests(const std::string& dir) {
+
+  std::vector<std::vector<std::pair<std::string, tf::Tensor>>> requests;
+  const std::string file = dir + "/assets.extra/tf_serving_warmup_requests";
+  tf::Env* env = tf::Env::Default();
+  if (!env->FileExists(file).ok()) return requests;
+  std::unique_ptr<tf::RandomAccessFile> record_file;
+  tf::Status status = env->NewRandomAccessFile(file, &record_file);
+  if (!status.ok())
+    throw std::runtime_error("Failed to open warmup requests: " +
+                             status.ToString());
+
+  // PredictionLog.predict_log (6) > PredictLog.request (1) >
+  // PredictRequest.inputs (2) > map entry key (1) / value (2)
+  tf::io::RecordReader reader(record_file.get());
+  tf::uint64 offset = 0;
+  tf::tstring record;
+  while (reader.ReadRecord(&offset, &record).ok()) {
+    const std::string prediction_log(record.data(), record.size());
+    for (const auto& predict_log : getProtoFieldValues(prediction_log, 6)) {
+      for (const auto& request : getProtoFieldValues(predict_log, 1)) {
+        std::vector<std::pair<std::string, tf::Tensor>> inputs;
+        for (const auto& entry : getProtoFieldValues(request, 2)) {
+          const auto keys = getProtoFieldValues(entry, 1);
+          const auto values = getProtoFieldValues(entry, 2);
+          tf::TensorProto proto;
+          tf::Tensor tensor;
+          if (keys.empty() || values.empty() ||
+              !proto.ParseFromString(values[0]) || !tensor.FromProto(proto))
+            throw std::runtime_error("Failed to parse warmup request in " +
+                                     file);
+          inputs.emplace_back(keys[0], tensor);
+        }
+        requests.push_back(inputs);
+      }
+    }
+  }
+
+  return requests;
 }
 
 
@@ -0,0 +1,320 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief StreamingSession class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/utils.h>
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Runs a stateful model step by step, feeding state outputs back as
+ * state inputs.
+ *
+ * State bindings map model outputs, e.g. RNN hidden states, to the model
+ * inputs they are fed to on the next step. State tensors are kept in GPU
+ * memory between steps if available, so only the remaining inputs/outputs
+ * are transferred. A streaming session keeps per-stream state and is not
+ * thread-safe; the model must outlive it.
+ */
+class StreamingSession {
+
+ public:
+  /**
+   * @brief Creates a streaming session with zero-initialized state.
+   *
+   * @param[in]  model                 loaded model
+   * @param[in]  state_bindings        pairs of state output and state input
+   * names, using the conventions of the name-based `Model::operator()`
+   * @param[in]  keep_state_on_device  keep state in GPU memory, if available
+   */
+  StreamingSession(
+    const Model& model,
+    const std::vector<std::pair<std::string, std::string>>& state_bindings,
+    const bool keep_state_on_device = true)
+      : model_(&model) {
+
+    if (!model.isLoaded())
+      throw std::runtime_error("Cannot stream model that is not loaded");
+
+    // split inputs/outputs into regular and state inputs/outputs
+    const auto& model_inputs = model.inputNames();
+    const auto& model_outputs = model.outputNames();
+    for (const auto& binding : state_bindings) {
+      if (std::find(model_outputs.begin(), model_outputs.end(),
+                    binding.first) == model_outputs.end())
+        throw std::runtime_error("Unknown state output '" + binding.first +
+                                 "'");
+      if (std::find(model_inputs.begin(), model_inputs.end(),
+                    binding.second) == model_inputs.end())
+        throw std::runtime_error("Unknown state input '" + binding.second +
+                                 "'");
+      state_output_names_.push_back(binding.first);
+      state_input_names_.push_back(binding.second);
+    }
+    for (const auto& name : model_inputs)
+      if (std::find(state_input_names_.begin(), state_input_names_.end(),
+                    name) == state_input_names_.end())
+        input_names_.push_back(name);
+    for (const auto& name : model_outputs)
+      if (std::find(state_output_names_.begin(), state_output_names_.end(),
+                    name) == state_output_names_.end())
+        output_names_.push_back(name);
+
+    // precompile steps, state is fed from host after (re)initialization,
+    // stateless sessions have no state to keep on the device
+    std::vector<std::string> feeds = input_names_;
+    std::vector<std::string> fetches = output_names_;
+    feeds.insert(feeds.end(), state_input_names_.begin(),
+                 state_input_names_.end());
+    fetches.insert(fetches.end(), state_output_names_.begin(),
+                   state_output_names_.end());
+    const std::string state_device =
+      (keep_state_on_device && !state_input_names_.empty())
+        ? model.gpuDeviceName()
+        : "";
+    std::vector<std::string> host_feed_devices(feeds.size());
+    std::vector<std::string> feed_devices(input_names_.size());
+    std::vector<std::string> fetch_devices(output_names_.size());
+    feed_devices.resize(feeds.size(), state_device);
+    fetch_devices.resize(fetches.size(), state_device);
+    step_callable_ = model.makeCallableOnDevices(feeds, fetches, feed_devices,
+                                                 fetch_devices);
+    if (!state_device.empty())
+      init_callable_ = model.makeCallableOnDevices(
+        feeds, fetches, host_feed_devices, fetch_devices);
+
+    reset();
+  }
+
+  StreamingSession(const StreamingSession&) = delete;
+  StreamingSession& operator=(const StreamingSession&) = delete;
+
+  /**
+   * @brief Releases the precompiled steps.
+   */
+  ~StreamingSession() {
+
+    try {
+      model_->releaseCallable(step_callable_);
+      model_->releaseCallable(init_callable_);
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  /**
+   * @brief Runs a single step.
+   *
+   * @param[in]  input_tensors            regular input tensors, in the order
+   * given by `inputNames`
+   *
+   * @return  std::vector<tf::Tensor>     regular output tensors, in the order
+   * given by `outputNames`
+   */
+  std::vector<tf::Tensor> operator()(
+    const std::vector<tf::Tensor>& input_tensors) {
+
+    if (input_tensors.size() != input_names_.size()) {
+      throw std::runtime_error(
+        "Streaming session has " + std::to_string(input_names_.size()) +
+        " regular inputs, but " + std::to_string(input_tensors.size()) +
+        " input tensors were given");
+    }
+
+    // feed regular inputs and current state
+    feeds_.assign(input_tensors.begin(), input_tensors.end());
+    feeds_.insert(feeds_.end(), state_.begin(), state_.end());
+    const Callable& callable =
+      state_on_host_ && init_callable_.is_valid ? init_callable_
+                                                : step_callable_;
+    model_->run(callable, feeds_, fetches_);
+    state_on_host_ = false;
+
+    // keep state, return regular outputs
+    const int n_outputs = output_names_.size();
+    state_.assign(fetches_.begin() + n_outputs, fetches_.end());
+    std::vector<tf::Tensor> output_tensors(fetches_.begin(),
+                                           fetches_.begin() + n_outputs);
+
+    return output_tensors;
+  }
+
+  /**
+   * @brief Resets the state to zero.
+   *
+   * Shapes and datatypes are inferred from the state inputs as in
+   * `Model::makeDummyInputs`.
+   *
+   * @param[in]  batch_size  batch size for dynamic batch dimension
+   */
+  void reset(const int batch_size = 1) {
+
+    const Model& model = *model_;
+    state_.clear();
+    for (const auto& name : state_input_names_) {
+      const std::vector<int> shape = model.getNodeShape(name);
+      std::vector<long int> state_shape(shape.begin(), shape.end());
+      if (!state_shape.empty() && state_shape[0] == -1l)
+        state_shape[0] = batch_size;
+      std::replace(state_shape.begin(), state_shape.end(), -1l, 1l);
+      state_.push_back(makeZeroTensor(
+        model.getNodeType(name),
+        tf::TensorShape(tf::gtl::ArraySlice<long int>(state_shape))));
+    }
+    state_on_host_ = true;
+  }
+
+  /**
+   * @brief Sets the state, e.g. to resume a stream.
+   *
+   * @param[in]  state  host state tensors, in the order of the state bindings
+   */
+  void setState(const std::vector<tf::Tensor>& state) {
+
+    if (state.size() != state_input_names_.size())
+      throw std::runtime_error("Streaming session has " +
+                               std::to_string(state_input_names_.size()) +
+                               " state tensors, but " +
+                               std::to_string(state.size()) + " were given");
+    state_ = state;
+    state_on_host_ = true;
+  }
+
+  /**
+   * @brief Returns the current state.
+   *
+   * After a step and with state kept on device, the tensors reside in GPU
+   * memory.
+   *
+   * @return  const std::vector<tf::Tensor>&  state tensors, in the order of
+   * the state bindings
+   */
+  const std::vector<tf::Tensor>& state() const {
+    return state_;
+  }
+
+  /**
+   * @brief Returns whether the state is kept in GPU memory between steps.
+   *
+   * @return  true   if state is kept on device
+   * @return  false  if state is kept on host
+   */
+  bool isStateOnDevice() const {
+    return init_callable_.is_valid;
+  }
+
+  /**
+   * @brief Returns the names of the regular (non-state) inputs.
+   *
+   * @return  const std::vector<std::string>&  input names
+   */
+  const std::vector<std::string>& inputNames() const {
+    return input_names_;
+  }
+
+  /**
+   * @brief Returns the names of the regular (non-state) outputs.
+   *
+   * @return  const std::vector<std::string>&  output names
+   */
+  const std::vector<std::string>& outputNames() const {
+    return output_names_;
+  }
+
+ protected:
+  /**
+   * @brief streamed model
+   */
+  const Model* model_;
+
+  /**
+   * @brief names of regular inputs
+   */
+  std::vector<std::string> input_names_;
+
+  /**
+   * @brief names of regular outputs
+   */
+  std::vector<std::string> output_names_;
+
+  /**
+   * @brief names of state inputs, in binding order
+   */
+  std::vector<std::string> state_input_names_;
+
+  /**
+   * @brief names of state outputs, in binding order
+   */
+  std::vector<std::string> state_output_names_;
+
+  /**
+   * @brief callable running a step with state on device (or host)
+   */
+  Callable step_callable_;
+
+  /**
+   * @brief callable running a step with state fed from host, only valid if
+   * state is kept on device
+   */
+  Callable init_callable_;
+
+  /**
+   * @brief current state tensors
+   */
+  std::vector<tf::Tensor> state_;
+
+  /**
+   * @brief whether the current state resides in host memory
+   */
+  bool state_on_host_ = true;
+
+  /**
+   * @brief reused feed tensors
+   */
+  std::vector<tf::Tensor> feeds_;
+
+  /**
+   * @brief reused fetch tensors
+   */
+  std::vector<tf::Tensor> fetches_;
+};
+
+
+}  // namespace tensorflow_cpp
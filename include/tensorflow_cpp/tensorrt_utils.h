@@ -0,0 +1,249 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Utility functions for running SavedModels with TF-TRT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/cc/saved_model/loader.h>
+#include <tensorflow/cc/saved_model/reader.h>
+#include <tensorflow/cc/saved_model/tag_constants.h>
+#include <tensorflow/core/platform/env.h>
+#include <tensorflow/core/platform/hash.h>
+#include <tensorflow/core/platform/path.h>
+#include <tensorflow_cpp/graph_utils.h>
+#include <tensorflow_cpp/utils.h>
+
+#if GOOGLE_CUDA && GOOGLE_TENSORRT
+#include <tensorflow/compiler/tf2tensorrt/trt_convert_api.h>
+#endif
+
+
+namespace tensorflow_cpp {
+
+
+namespace tf = tensorflow;
+
+
+/**
+ * @brief Checks whether TensorFlow was built with TensorRT support.
+ *
+ * @return  true   if TF-TRT is available
+ * @return  false  otherwise
+ */
+inline bool isTensorRTAvailable() {
+
+#if GOOGLE_CUDA && GOOGLE_TENSORRT
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+/**
+ * @brief Determines the file a SavedModel converted with TF-TRT is cached in.
+ *
+ * The file name contains the precision and a hash of the SavedModel graph,
+ * so that changed models are converted again.
+ *
+ * @param[in]  dir                SavedModel directory
+ * @param[in]  config             session configuration
+ *
+ * @return  std::string           cache file
+ */
+inline std::string getTensorRTCachePath(const std::string& dir,
+                                        const SessionConfig& config) {
+
+  std::string saved_model_pb;
+  tf::Status status = tf::ReadFileToString(
+    tf::Env::Default(), tf::io::JoinPath(dir, "saved_model.pb"),
+    &saved_model_pb);
+  if (!status.ok())
+    throw std::runtime_error("Failed to read SavedModel: " +
+                             status.ToString());
+
+  std::string model_dir = dir;
+  while (model_dir.size() > 1 && model_dir.back() == '/') model_dir.pop_back();
+  const size_t slash = model_dir.rfind('/');
+  const std::string model_name =
+    (slash != std::string::npos) ? model_dir.substr(slash + 1) : model_dir;
+  const std::string cache_dir =
+    !config.engine_cache_dir.empty()
+      ? config.engine_cache_dir
+      : ((slash != std::string::npos) ? model_dir.substr(0, slash) : ".");
+
+  const char* precisions[] = {"fp32", "fp16", "bf16", "int8"};
+  std::stringstream file;
+  file << model_name << ".tensorrt-"
+       << precisions[static_cast<int>(config.precision)] << "-" << std::hex
+       << std::setw(16) << std::setfill('0') << tf::Hash64(saved_model_pb)
+       << ".pb";
+
+  return tf::io::JoinPath(cache_dir, file.str());
+}
+
+
+/**
+ * @brief Loads a SavedModel, converting its default signature with TF-TRT.
+ *
+ * Supported subgraphs are replaced by TensorRT engines in the precision given
+ * by `config.precision`. If `config.engine_build_inputs` are given, engines
+ * are built ahead of time (and int8 precision is calibrated on them),
+ * otherwise on first use. The converted graph is cached (see
+ * `getTensorRTCachePath`) and loaded from there on later startups. Only the
+ * default signature "serving_default" is kept.
+ *
+ * @param[in]  dir                        SavedModel directory
+ * @param[in]  config                     session configuration
+ *
+ * @return  tf::SavedModelBundleLite      SavedModel running TF-TRT
+ */
+inline tf::SavedModelBundleLite loadSavedModelWithTensorRT(
+  const std::string& dir, const SessionConfig& config) {
+
+#if GOOGLE_CUDA && GOOGLE_TENSORRT
+  const std::string signature_key = "serving_default";
+  const std::string cache_file = getTensorRTCachePath(dir, config);
+  tf::Env* env = tf::Env::Default();
+  tf::GraphDef graph_def;
+  tf::MetaGraphDef meta_graph_def;
+  tf::Status status;
+
+  if (env->FileExists(cache_file).ok() &&
+      tf::ReadBinaryProto(env, cache_file, &graph_def).ok()) {
+
+    status = tf::ReadMetaGraphDefFromSavedModel(
+      dir, {tf::kSavedModelTagServe}, &meta_graph_def);
+    if (!status.ok())
+      throw std::runtime_error("Failed to load SavedModel: " +
+                               status.ToString());
+
+  } else {
+
+    tf::SavedModelBundle bundle;
+    SessionConfig tf_config = config;
+    tf_config.backend = Backend::kTensorFlow;
+    tf_config.precision = Precision::kDefault;
+    status = tf::LoadSavedModel(makeSessionOptions(tf_config),
+                                config.run_options, dir,
+                                {tf::kSavedModelTagServe}, &bundle);
+    if (!status.ok())
+      throw std::runtime_error("Failed to load SavedModel: " +
+                               status.ToString());
+    meta_graph_def = bundle.meta_graph_def;
+    const auto signature = meta_graph_def.signature_def().find(signature_key);
+    if (signature == meta_graph_def.signature_def().end())
+      throw std::runtime_error("TensorRT backend requires a '" +
+                               signature_key + "' signature");
+
+    // TF-TRT expects inputs in signature order, build inputs are sorted by
+    // node name like `getSavedModelInputNames`
+    std::vector<std::string> sorted_nodes;
+    for (const auto& input : signature->second.inputs())
+      sorted_nodes.push_back(input.second.name());
+    std::sort(sorted_nodes.begin(), sorted_nodes.end());
+    std::vector<std::vector<tf::Tensor>> build_inputs;
+    for (const auto& inputs : config.engine_build_inputs) {
+      if (inputs.size() != sorted_nodes.size())
+        throw std::runtime_error("Engine build inputs do not match signature");
+      std::vector<tf::Tensor> signature_inputs;
+      for (const auto& input : signature->second.inputs()) {
+        const auto idx = std::find(sorted_nodes.begin(), sorted_nodes.end(),
+                                   input.second.name()) -
+                         sorted_nodes.begin();
+        signature_inputs.push_back(inputs[idx]);
+      }
+      build_inputs.push_back(signature_inputs);
+    }
+
+    tf::tensorrt::TfTrtConversionParams params;
+    params.use_dynamic_shape = true;
+    params.allow_build_at_runtime = true;
+    params.convert_to_static_engine = !build_inputs.empty();
+    switch (config.precision) {
+      case Precision::kDefault:
+        params.precision_mode = tf::tensorrt::TrtPrecisionMode::FP32;
+        break;
+      case Precision::kFloat16:
+        params.precision_mode = tf::tensorrt::TrtPrecisionMode::FP16;
+        break;
+      case Precision::kInt8:
+        if (build_inputs.empty())
+          throw std::runtime_error(
+            "Int8 precision requires engine build inputs for calibration");
+        params.precision_mode = tf::tensorrt::TrtPrecisionMode::INT8;
+        params.use_calibration = true;
+        break;
+      default:
+        throw std::runtime_error("Precision is not supported by TensorRT");
+    }
+
+    auto converted = tf::tensorrt::ConvertAndBuild(&bundle, signature_key,
+                                                   build_inputs, params);
+    if (!converted.ok())
+      throw std::runtime_error("Failed to convert SavedModel with TensorRT: " +
+                               converted.status().ToString());
+    graph_def = std::move(converted.ValueOrDie());
+
+    // caching is best-effort, write to a temporary file first
+    const std::string tmp_file =
+      cache_file + ".tmp" + std::to_string(env->NowMicros());
+    if (tf::WriteBinaryProto(env, tmp_file, graph_def).ok() &&
+        !env->RenameFile(tmp_file, cache_file).ok())
+      env->DeleteFile(tmp_file).IgnoreError();
+  }
+
+  // the converted graph is frozen, so there is nothing to restore
+  std::unique_ptr<tf::Session> session(createSession(config));
+  loadGraphIntoSession(session.get(), graph_def);
+  auto signatures = meta_graph_def.signature_def();
+  for (auto it = signatures.begin(); it != signatures.end();) {
+    if (it->first != signature_key)
+      it = signatures.erase(it);
+    else
+      ++it;
+  }
+
+  return tf::SavedModelBundleLite(std::move(session), std::move(signatures));
+#else
+  (void)dir;
+  (void)config;
+  throw std::runtime_error(
+    "TensorRT backend requires TensorFlow built with TensorRT");
+#endif
+}
+
+
+}  // namespace tensorflow_cpp
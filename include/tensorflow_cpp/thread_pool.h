@@ -0,0 +1,191 @@
+/*
+==============================================================================
+MIT License
+Copyright 2022 Institute for Automotive Engineering of RWTH Aachen University.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================
+*/
+
+/**
+ * @file
+ * @brief ThreadPool class
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace tensorflow_cpp {
+
+
+/**
+ * @brief Simple fixed-size thread pool for running tasks in the background.
+ *
+ * Worker threads are only spawned once the first task is scheduled. On
+ * destruction, all queued tasks are finished before the threads are joined.
+ */
+class ThreadPool {
+
+ public:
+  /**
+   * @brief Creates a thread pool.
+   *
+   * @param[in]  n_threads  number of worker threads (0: number of cores)
+   */
+  explicit ThreadPool(const int n_threads = 1)
+      : n_threads_(n_threads > 0
+                     ? n_threads
+                     : std::max(1u, std::thread::hardware_concurrency())) {}
+
+  /**
+   * @brief Finishes all queued tasks and joins the worker threads.
+   */
+  ~ThreadPool() {
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Schedules a task for execution on one of the worker threads.
+   *
+   * The task must not throw, use `submit` for tasks that may throw.
+   *
+   * @param[in]  task  task
+   */
+  void schedule(std::function<void()> task) {
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (threads_.empty()) {
+        for (int k = 0; k < n_threads_; k++)
+          threads_.emplace_back(&ThreadPool::work, this);
+      }
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  /**
+   * @brief Schedules a task and returns a future for its result.
+   *
+   * Exceptions thrown by the task are passed on through the future.
+   *
+   * @param[in]  f                        task
+   *
+   * @return  std::future<decltype(f())>  result of task
+   */
+  template <typename F>
+  auto submit(F&& f) -> std::future<decltype(f())> {
+
+    using R = decltype(f());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    std::future<R> future = task->get_future();
+    schedule([task]() { (*task)(); });
+
+    return future;
+  }
+
+  /**
+   * @brief Returns the number of worker threads.
+   *
+   * @return  int  number of worker threads
+   */
+  int nThreads() const {
+    return n_threads_;
+  }
+
+  /**
+   * @brief Returns the number of tasks waiting for execution.
+   *
+   * @return  int  number of queued tasks
+   */
+  int queueSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+  }
+
+ protected:
+  /**
+   * @brief Runs queued tasks until stopped.
+   */
+  void work() {
+
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty()) return;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+ protected:
+  /**
+   * @brief number of worker threads
+   */
+  const int n_threads_;
+
+  /**
+   * @brief worker threads
+   */
+  std::vector<std::thread> threads_;
+
+  /**
+   * @brief queued tasks
+   */
+  std::deque<std::function<void()>> tasks_;
+
+  /**
+   * @brief whether the worker threads are requested to stop
+   */
+  bool stop_ = false;
+
+  /**
+   * @brief mutex guarding the task queue
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * @brief condition variable signaling new tasks
+   */
+  std::condition_variable cv_;
+};
+
+
+}  // namespace tensorflow_cpp
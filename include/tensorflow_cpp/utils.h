@@ -27,11 +27,22 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <tensorflow/core/framework/allocation_description.pb.h>
+#include <tensorflow/core/framework/device_factory.h>
+#include <tensorflow/core/framework/tensor.h>
+#include <tensorflow/core/framework/types.h>
 #include <tensorflow/core/platform/env.h>
 #include <tensorflow/core/public/session.h>
+#include <tensorflow_cpp/observer.h>
 
 
 namespace tensorflow_cpp {
@@ -41,48 +52,389 @@ namespace tf = tensorflow;
 
 
 /**
- * @brief Helps to quickly create SessionOptions.
+ * @brief Precision to run a model in.
+ *
+ * Reduced precisions are applied by Grappler's automatic mixed precision when
+ * the session is created, or by TensorRT with `Backend::kTensorRT`. Either
+ * way, model inputs and outputs keep their exported datatypes; casts are
+ * inserted at the boundary of converted subgraphs.
+ */
+enum class Precision {
+  /**
+   * @brief precision the model was exported with
+   */
+  kDefault,
+  /**
+   * @brief float16 on GPU (requires compute capability 7.0 or newer)
+   */
+  kFloat16,
+  /**
+   * @brief bfloat16 on CPU (requires TensorFlow built with oneDNN)
+   */
+  kBFloat16,
+  /**
+   * @brief int8 calibrated on `SessionConfig::engine_build_inputs` (requires
+   * `Backend::kTensorRT`)
+   */
+  kInt8
+};
+
+
+/**
+ * @brief Backend to run a model with.
+ */
+enum class Backend {
+  /**
+   * @brief plain TensorFlow runtime
+   */
+  kTensorFlow,
+  /**
+   * @brief TF-TRT engines for supported subgraphs of SavedModels (requires
+   * TensorFlow built with TensorRT), cached on disk
+   */
+  kTensorRT,
+  /**
+   * @brief XLA JIT compilation of the whole graph
+   */
+  kXla
+};
+
+
+/**
+ * @brief Checks applied to input tensors before running a model.
+ *
+ * Inputs are checked against the datatypes and shapes of the model inputs,
+ * with unknown dimensions matching any size. Checks compile to nothing if
+ * `TENSORFLOW_CPP_DISABLE_INPUT_VALIDATION` is defined.
+ */
+enum class InputValidation {
+  /**
+   * @brief no checks, mismatches are reported by the TensorFlow session
+   */
+  kNone,
+  /**
+   * @brief reject mismatching inputs before running the session
+   */
+  kCheck,
+  /**
+   * @brief cast and reshape mismatching inputs, see `convertInput`
+   */
+  kConvert
+};
+
+
+/**
+ * @brief Configuration of TensorFlow sessions created by tensorflow_cpp.
+ *
+ * Defaults match TensorFlow's defaults, except for `allow_growth`.
+ */
+struct SessionConfig {
+
+  /**
+   * @brief dynamically grow GPU usage
+   */
+  bool allow_growth = true;
+
+  /**
+   * @brief maximum GPU memory fraction (0: no limit)
+   */
+  double per_process_gpu_memory_fraction = 0;
+
+  /**
+   * @brief list of GPUs to use, e.g. "0,1"
+   */
+  std::string visible_device_list = "";
+
+  /**
+   * @brief memory limits of virtual GPUs to split every visible GPU into
+   * (empty: one GPU per physical GPU)
+   *
+   * Each virtual GPU has its own memory arena, so models placed on different
+   * virtual GPUs via `device` cannot starve each other. TensorFlow configures
+   * GPUs once per process, so all sessions have to use the same limits.
+   */
+  std::vector<double> gpu_memory_limits_mb;
+
+  /**
+   * @brief whether to reserve the full memory arena of the model's GPU on
+   * load instead of growing it on demand; implies `allow_growth = false`
+   */
+  bool preallocate_gpu_memory = false;
+
+  /**
+   * @brief threads per op (0: auto)
+   */
+  int intra_op_parallelism_threads = 0;
+
+  /**
+   * @brief threads across ops (0: auto)
+   */
+  int inter_op_parallelism_threads = 0;
+
+  /**
+   * @brief whether to use session-specific instead of process-wide thread
+   * pools
+   */
+  bool use_per_session_threads = false;
+
+  /**
+   * @brief XLA JIT compilation level for the whole graph
+   */
+  tf::OptimizerOptions::GlobalJitLevel global_jit_level =
+    tf::OptimizerOptions::DEFAULT;
+
+  /**
+   * @brief Grappler constant folding
+   */
+  tf::RewriterConfig::Toggle constant_folding = tf::RewriterConfig::DEFAULT;
+
+  /**
+   * @brief Grappler layout optimizer
+   */
+  tf::RewriterConfig::Toggle layout_optimizer = tf::RewriterConfig::DEFAULT;
+
+  /**
+   * @brief Grappler op fusion (remapping)
+   */
+  tf::RewriterConfig::Toggle remapping = tf::RewriterConfig::DEFAULT;
+
+  /**
+   * @brief Grappler automatic mixed precision (float16 on GPU)
+   */
+  tf::RewriterConfig::Toggle auto_mixed_precision = tf::RewriterConfig::DEFAULT;
+
+  /**
+   * @brief precision to run the model in, overrides `auto_mixed_precision`
+   * unless `Precision::kDefault`
+   */
+  Precision precision = Precision::kDefault;
+
+  /**
+   * @brief backend to run the model with
+   */
+  Backend backend = Backend::kTensorFlow;
+
+  /**
+   * @brief directory for caching converted TensorRT models (empty: next to
+   * the model)
+   */
+  std::string engine_cache_dir = "";
+
+  /**
+   * @brief sample inputs, ordered like `Model::inputNames`, to build TensorRT
+   * engines with ahead of time and to calibrate int8 precision on (empty:
+   * engines are built on first use)
+   */
+  std::vector<std::vector<tf::Tensor>> engine_build_inputs;
+
+  /**
+   * @brief observer notified around every session run of the model, see
+   * `Model::setObserver` (nullptr: none)
+   */
+  std::shared_ptr<ModelObserver> observer;
+
+  /**
+   * @brief checks applied to input tensors on every call (TensorFlow itself
+   * does not enforce the shapes of fed inputs)
+   */
+  InputValidation input_validation = InputValidation::kNone;
+
+  /**
+   * @brief run options used when loading SavedModels
+   */
+  tf::RunOptions run_options;
+
+  /**
+   * @brief whether FrozenGraphs are stored in memmapped file system format
+   * (see `convert_graphdef_memmapped_format`), mapping constant weights into
+   * memory instead of copying them
+   */
+  bool memmapped_graph = false;
+
+  /**
+   * @brief whether to keep the full FrozenGraph GraphDef in memory after the
+   * session has been created; otherwise only input/output nodes are kept
+   */
+  bool keep_graph_def = true;
+
+  /**
+   * @brief whether to optimize FrozenGraphs for inference on load, see
+   * `optimizeFrozenGraph` (not applied to memmapped graphs)
+   */
+  bool optimize_graph = false;
+
+  /**
+   * @brief directory for caching optimized FrozenGraphs (empty: no caching)
+   */
+  std::string optimized_graph_cache_dir = "";
+
+  /**
+   * @brief device to place all nodes without explicit placement on, e.g.
+   * "/device:GPU:1" (empty: automatic placement); nodes unsupported by the
+   * device fall back to soft placement
+   */
+  std::string device = "";
+};
+
+
+/**
+ * @brief Creates a SessionConfig from the most common settings.
  *
  * @param[in]  allow_growth                     dynamically grow GPU usage
  * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
  * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
  *
- * @return  tf::SessionOptions                  session options
+ * @return  SessionConfig                       session configuration
  */
-inline tf::SessionOptions makeSessionOptions(
+inline SessionConfig makeSessionConfig(
   const bool allow_growth = true,
   const double per_process_gpu_memory_fraction = 0,
-  const std::string& visible_device_list = "") {
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
+
+  SessionConfig config;
+  config.allow_growth = allow_growth;
+  config.per_process_gpu_memory_fraction = per_process_gpu_memory_fraction;
+  config.visible_device_list = visible_device_list;
+  config.intra_op_parallelism_threads = intra_op_parallelism_threads;
+  config.inter_op_parallelism_threads = inter_op_parallelism_threads;
+
+  return config;
+}
+
+
+/**
+ * @brief Counts the physical GPUs visible to sessions with a configuration.
+ *
+ * Does not initialize the GPUs, unlike listing the devices of a session.
+ *
+ * @param[in]  config   session configuration
+ *
+ * @return  int         number of visible GPUs
+ */
+inline int countVisibleGpus(const SessionConfig& config) {
+
+  if (!config.visible_device_list.empty())
+    return std::count(config.visible_device_list.begin(),
+                      config.visible_device_list.end(), ',') +
+           1;
+  tf::DeviceFactory* factory = tf::DeviceFactory::GetFactory("GPU");
+  if (!factory) return 0;
+  std::vector<std::string> devices;
+  tf::Status status = factory->ListPhysicalDevices(&devices);
+  if (!status.ok())
+    throw std::runtime_error("Failed to list GPUs: " + status.ToString());
+
+  return devices.size();
+}
+
+
+/**
+ * @brief Helps to quickly create SessionOptions.
+ *
+ * @param[in]  config               session configuration
+ *
+ * @return  tf::SessionOptions      session options
+ */
+inline tf::SessionOptions makeSessionOptions(const SessionConfig& config) {
 
   tf::SessionOptions options = tf::SessionOptions();
-  tf::ConfigProto* config = &options.config;
-  tf::GPUOptions* gpu_options = config->mutable_gpu_options();
-  gpu_options->set_allow_growth(allow_growth);
+  tf::ConfigProto* config_proto = &options.config;
+  config_proto->set_intra_op_parallelism_threads(
+    config.intra_op_parallelism_threads);
+  config_proto->set_inter_op_parallelism_threads(
+    config.inter_op_parallelism_threads);
+  config_proto->set_use_per_session_threads(config.use_per_session_threads);
+
+  if (!config.device.empty()) config_proto->set_allow_soft_placement(true);
+
+  tf::GPUOptions* gpu_options = config_proto->mutable_gpu_options();
+  gpu_options->set_allow_growth(config.allow_growth &&
+                                !config.preallocate_gpu_memory);
   gpu_options->set_per_process_gpu_memory_fraction(
-    per_process_gpu_memory_fraction);
-  gpu_options->set_visible_device_list(visible_device_list);
+    config.per_process_gpu_memory_fraction);
+  gpu_options->set_visible_device_list(config.visible_device_list);
+  if (!config.gpu_memory_limits_mb.empty()) {
+    for (int k = 0; k < countVisibleGpus(config); k++) {
+      auto* virtual_devices =
+        gpu_options->mutable_experimental()->add_virtual_devices();
+      for (const double limit : config.gpu_memory_limits_mb)
+        virtual_devices->add_memory_limit_mb(limit);
+    }
+  }
+
+  tf::GraphOptions* graph_options = config_proto->mutable_graph_options();
+  graph_options->mutable_optimizer_options()->set_global_jit_level(
+    (config.backend == Backend::kXla &&
+     config.global_jit_level == tf::OptimizerOptions::DEFAULT)
+      ? tf::OptimizerOptions::ON_1
+      : config.global_jit_level);
+  tf::RewriterConfig* rewrite_options = graph_options->mutable_rewrite_options();
+  rewrite_options->set_constant_folding(config.constant_folding);
+  rewrite_options->set_layout_optimizer(config.layout_optimizer);
+  rewrite_options->set_remapping(config.remapping);
+  rewrite_options->set_auto_mixed_precision(config.auto_mixed_precision);
+  if (config.precision == Precision::kInt8 &&
+      config.backend != Backend::kTensorRT)
+    throw std::runtime_error("Int8 precision requires the TensorRT backend");
+  if (config.backend != Backend::kTensorRT) {
+    if (config.precision == Precision::kFloat16)
+      rewrite_options->set_auto_mixed_precision(tf::RewriterConfig::ON);
+    else if (config.precision == Precision::kBFloat16)
+      rewrite_options->set_auto_mixed_precision_mkl(tf::RewriterConfig::ON);
+  }
+
+  // constant folding would copy the memmapped constants into the graph
+  if (config.memmapped_graph)
+    graph_options->mutable_optimizer_options()->set_opt_level(
+      tf::OptimizerOptions::L0);
 
   return options;
 }
 
 
 /**
- * @brief Creates a new TensorFlow session.
+ * @brief Helps to quickly create SessionOptions.
  *
  * @param[in]  allow_growth                     dynamically grow GPU usage
  * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
  * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
  *
- * @return  tf::Session*                        session
+ * @return  tf::SessionOptions                  session options
  */
-inline tf::Session* createSession(
+inline tf::SessionOptions makeSessionOptions(
   const bool allow_growth = true,
   const double per_process_gpu_memory_fraction = 0,
-  const std::string& visible_device_list = "") {
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
+
+  return makeSessionOptions(makeSessionConfig(
+    allow_growth, per_process_gpu_memory_fraction, visible_device_list,
+    intra_op_parallelism_threads, inter_op_parallelism_threads));
+}
+
+
+/**
+ * @brief Creates a new TensorFlow session.
+ *
+ * @param[in]  config           session configuration
+ * @param[in]  env              environment, e.g. a `tf::MemmappedEnv`, which
+ * has to outlive the session (nullptr: default environment)
+ *
+ * @return  tf::Session*        session
+ */
+inline tf::Session* createSession(const SessionConfig& config,
+                                  tf::Env* env = nullptr) {
 
   tf::Session* session;
-  tf::SessionOptions options = makeSessionOptions(
-    allow_growth, per_process_gpu_memory_fraction, visible_device_list);
+  tf::SessionOptions options = makeSessionOptions(config);
+  if (env) options.env = env;
   tf::Status status = tf::NewSession(options, &session);
   if (!status.ok())
     throw std::runtime_error("Failed to create new session: " +
@@ -92,4 +444,270 @@ inline tf::Session* createSession(
 }
 
 
+/**
+ * @brief Creates a new TensorFlow session.
+ *
+ * @param[in]  allow_growth                     dynamically grow GPU usage
+ * @param[in]  per_process_gpu_memory_fraction  maximum GPU memory fraction
+ * @param[in]  visible_device_list              list of GPUs to use, e.g. "0,1"
+ * @param[in]  intra_op_parallelism_threads     threads per op (0: auto)
+ * @param[in]  inter_op_parallelism_threads     threads across ops (0: auto)
+ *
+ * @return  tf::Session*                        session
+ */
+inline tf::Session* createSession(
+  const bool allow_growth = true,
+  const double per_process_gpu_memory_fraction = 0,
+  const std::string& visible_device_list = "",
+  const int intra_op_parallelism_threads = 0,
+  const int inter_op_parallelism_threads = 0) {
+
+  return createSession(makeSessionConfig(
+    allow_growth, per_process_gpu_memory_fraction, visible_device_list,
+    intra_op_parallelism_threads, inter_op_parallelism_threads));
+}
+
+
+/**
+ * @brief Creates a zero-initialized tensor.
+ *
+ * @param[in]  dtype         datatype
+ * @param[in]  shape         shape
+ *
+ * @return  tf::Tensor       tensor
+ */
+inline tf::Tensor makeZeroTensor(const tf::DataType dtype,
+                                 const tf::TensorShape& shape) {
+
+  tf::Tensor tensor(dtype, shape);
+  // init to zero, based on type
+  switch (dtype) {
+    case tf::DT_FLOAT:
+      tensor.flat<float>().setZero();
+      break;
+    case tf::DT_DOUBLE:
+      tensor.flat<double>().setZero();
+      break;
+    case tf::DT_INT32:
+      tensor.flat<tf::int32>().setZero();
+      break;
+    case tf::DT_UINT32:
+      tensor.flat<tf::uint32>().setZero();
+      break;
+    case tf::DT_UINT8:
+      tensor.flat<tf::uint8>().setZero();
+      break;
+    case tf::DT_UINT16:
+      tensor.flat<tf::uint16>().setZero();
+      break;
+    case tf::DT_INT16:
+      tensor.flat<tf::int16>().setZero();
+      break;
+    case tf::DT_INT8:
+      tensor.flat<tf::int8>().setZero();
+      break;
+    case tf::DT_STRING:
+      tensor.flat<tf::tstring>().setZero();
+      break;
+    case tf::DT_COMPLEX64:
+      tensor.flat<tf::complex64>().setZero();
+      break;
+    case tf::DT_COMPLEX128:
+      tensor.flat<tf::complex128>().setZero();
+      break;
+    case tf::DT_INT64:
+      tensor.flat<tf::int64>().setZero();
+      break;
+    case tf::DT_UINT64:
+      tensor.flat<tf::uint64>().setZero();
+      break;
+    case tf::DT_BOOL:
+      tensor.flat<bool>().setZero();
+      break;
+    case tf::DT_QINT8:
+      tensor.flat<tf::qint8>().setZero();
+      break;
+    case tf::DT_QUINT8:
+      tensor.flat<tf::quint8>().setZero();
+      break;
+    case tf::DT_QUINT16:
+      tensor.flat<tf::quint16>().setZero();
+      break;
+    case tf::DT_QINT16:
+      tensor.flat<tf::qint16>().setZero();
+      break;
+    case tf::DT_QINT32:
+      tensor.flat<tf::qint32>().setZero();
+      break;
+    case tf::DT_BFLOAT16:
+      tensor.flat<tf::bfloat16>().setZero();
+      break;
+    case tf::DT_HALF:
+      tensor.flat<Eigen::half>().setZero();
+      break;
+  }
+
+  return tensor;
+}
+
+
+/**
+ * @brief Tensor buffer referencing memory owned by the user.
+ *
+ * See `wrapBuffer`.
+ */
+class UserTensorBuffer : public tf::TensorBuffer {
+
+ public:
+  /**
+   * @brief Creates a tensor buffer referencing user memory.
+   *
+   * @param[in]  data     user memory
+   * @param[in]  size     size of user memory in bytes
+   * @param[in]  release  invoked once the buffer is no longer referenced
+   */
+  UserTensorBuffer(void* data, const size_t size,
+                   std::function<void()> release)
+      : tf::TensorBuffer(data), size_(size), release_(std::move(release)) {}
+
+  size_t size() const override {
+    return size_;
+  }
+
+  tf::TensorBuffer* root_buffer() override {
+    return this;
+  }
+
+  void FillAllocationDescription(
+    tf::AllocationDescription* proto) const override {
+
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("tensorflow_cpp_user_buffer");
+  }
+
+  bool OwnsMemory() const override {
+    return false;
+  }
+
+ protected:
+  ~UserTensorBuffer() override {
+    if (release_) release_();
+  }
+
+ protected:
+  /**
+   * @brief size of user memory in bytes
+   */
+  const size_t size_;
+
+  /**
+   * @brief invoked once the buffer is no longer referenced
+   */
+  std::function<void()> release_;
+};
+
+
+/**
+ * @brief Wraps an existing user buffer as tensor without copying.
+ *
+ * The buffer has to be aligned to `EIGEN_MAX_ALIGN_BYTES` (64 bytes on most
+ * platforms) and stay valid as long as the tensor or any tensor sharing its
+ * buffer is alive, e.g. by capturing its owner in `release`. Only datatypes
+ * that can be copied with memcpy are supported, i.e. no strings.
+ *
+ * @param[in]  data       buffer of `shape.num_elements()` elements of `dtype`
+ * @param[in]  dtype      datatype
+ * @param[in]  shape      shape
+ * @param[in]  release    invoked once the buffer is no longer referenced, also
+ * if wrapping fails
+ *
+ * @return  tf::Tensor    tensor referencing the buffer
+ */
+inline tf::Tensor wrapBuffer(void* data, const tf::DataType dtype,
+                             const tf::TensorShape& shape,
+                             std::function<void()> release = nullptr) {
+
+  const bool is_aligned =
+    EIGEN_MAX_ALIGN_BYTES == 0 || shape.num_elements() == 0 ||
+    reinterpret_cast<std::uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0;
+  if (!tf::DataTypeCanUseMemcpy(dtype) || !is_aligned) {
+    if (release) release();
+    if (!tf::DataTypeCanUseMemcpy(dtype))
+      throw std::runtime_error("Cannot wrap buffer of datatype " +
+                               tf::DataTypeString(dtype));
+    throw std::runtime_error("Cannot wrap buffer that is not aligned to " +
+                             std::to_string(EIGEN_MAX_ALIGN_BYTES) + " bytes");
+  }
+
+  UserTensorBuffer* buffer = new UserTensorBuffer(
+    data, shape.num_elements() * tf::DataTypeSize(dtype), std::move(release));
+  tf::Tensor tensor(dtype, shape, buffer);
+  buffer->Unref();  // tensor holds its own reference
+
+  return tensor;
+}
+
+
+/**
+ * @brief Wraps an existing typed user buffer as tensor without copying.
+ *
+ * See `wrapBuffer`.
+ *
+ * @param[in]  data       buffer of `shape.num_elements()` elements
+ * @param[in]  shape      shape
+ * @param[in]  release    invoked once the buffer is no longer referenced
+ *
+ * @return  tf::Tensor    tensor referencing the buffer
+ */
+template <typename T>
+inline tf::Tensor wrapBuffer(T* data, const tf::TensorShape& shape,
+                             std::function<void()> release = nullptr) {
+
+  return wrapBuffer(static_cast<void*>(data), tf::DataTypeToEnum<T>::value,
+                    shape, std::move(release));
+}
+
+
+/**
+ * @brief Returns a typed read-only view of the elements of a tensor.
+ *
+ * @param[in]  tensor                     tensor
+ *
+ * @return  tf::gtl::ArraySlice<T>        elements in row-major order, valid as
+ * long as the tensor's buffer is alive
+ */
+template <typename T>
+inline tf::gtl::ArraySlice<T> tensorSpan(const tf::Tensor& tensor) {
+
+  if (tensor.dtype() != tf::DataTypeToEnum<T>::value)
+    throw std::runtime_error("Cannot view tensor of datatype " +
+                             tf::DataTypeString(tensor.dtype()) + " as " +
+                             tf::DataTypeString(tf::DataTypeToEnum<T>::value));
+
+  return tf::gtl::ArraySlice<T>(tensor.unaligned_flat<T>().data(),
+                                tensor.NumElements());
+}
+
+
+/**
+ * @brief Returns a typed mutable view of the elements of a tensor.
+ *
+ * @param[in]  tensor                     tensor
+ *
+ * @return  tf::gtl::MutableArraySlice<T> elements in row-major order, valid as
+ * long as the tensor's buffer is alive
+ */
+template <typename T>
+inline tf::gtl::MutableArraySlice<T> tensorMutableSpan(tf::Tensor& tensor) {
+
+  if (tensor.dtype() != tf::DataTypeToEnum<T>::value)
+    throw std::runtime_error("Cannot view tensor of datatype " +
+                             tf::DataTypeString(tensor.dtype()) + " as " +
+                             tf::DataTypeString(tf::DataTypeToEnum<T>::value));
+
+  return tf::gtl::MutableArraySlice<T>(tensor.unaligned_flat<T>().data(),
+                                       tensor.NumElements());
+}
+
+
 }  // namespace tensorflow_cpp
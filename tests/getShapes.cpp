@@ -34,3 +34,20 @@ TEST(tensorflow_cpp, getShapes) {
   for (int d = 0; d < output_shape.size(); d++)
     EXPECT_EQ(output_shape[d], expected_output_shape[d]);
 }
+
+
+TEST(tensorflow_cpp, getSignatureShapes) {
+
+  tensorflow_cpp::Model model(model_path);
+
+  // cached shapes match the underlying SavedModel signature
+  const tensorflow_cpp::Signature& signature =
+    model.signature(model.signatureNames()[0]);
+  ASSERT_EQ(signature.input_shapes.size(), signature.input_nodes.size());
+  for (int k = 0; k < signature.input_nodes.size(); k++)
+    EXPECT_EQ(signature.input_shapes[k],
+              tensorflow_cpp::getSavedModelNodeShape(
+                model.savedModel(), signature.input_nodes[k], signature.name));
+  EXPECT_EQ(model.getInputShapes()[0], model.getInputShape());
+  EXPECT_EQ(model.getOutputShapes()[0], model.getOutputShape());
+}
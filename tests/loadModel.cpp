@@ -21,3 +21,181 @@ TEST(tensorflow_cpp, loadModel) {
 
   EXPECT_TRUE(model.isLoaded());
 }
+
+
+TEST(tensorflow_cpp, loadModelWithConfig) {
+
+  tensorflow_cpp::SessionConfig config;
+  config.intra_op_parallelism_threads = 2;
+  config.inter_op_parallelism_threads = 1;
+  config.use_per_session_threads = true;
+  config.constant_folding = tensorflow::RewriterConfig::ON;
+  tensorflow_cpp::Model model(model_path, config, true);
+
+  EXPECT_TRUE(model.isLoaded());
+  EXPECT_EQ(model.sessionConfig().intra_op_parallelism_threads, 2);
+}
+
+
+TEST(tensorflow_cpp, loadModelWithPrecision) {
+
+  // reduced precision is internal, the model boundary keeps its datatypes
+  for (const auto precision : {tensorflow_cpp::Precision::kFloat16,
+                               tensorflow_cpp::Precision::kBFloat16}) {
+    tensorflow_cpp::SessionConfig config;
+    config.precision = precision;
+    tensorflow_cpp::Model model(model_path, config);
+    ASSERT_TRUE(model.isLoaded());
+    const std::vector<tensorflow::Tensor> outputs =
+      model(model.makeDummyInputs());
+    ASSERT_EQ(outputs.size(), model.nOutputs());
+    for (int k = 0; k < outputs.size(); k++)
+      EXPECT_EQ(outputs[k].dtype(), model.getOutputTypes()[k]);
+  }
+}
+
+
+TEST(tensorflow_cpp, loadModelWithBackend) {
+
+  tensorflow_cpp::SessionConfig config;
+  config.backend = tensorflow_cpp::Backend::kXla;
+  tensorflow_cpp::Model model(model_path, config);
+  ASSERT_TRUE(model.isLoaded());
+  EXPECT_EQ(model(model.makeDummyInputs()).size(), model.nOutputs());
+
+  config.backend = tensorflow_cpp::Backend::kTensorFlow;
+  config.precision = tensorflow_cpp::Precision::kInt8;
+  EXPECT_THROW(tensorflow_cpp::Model(model_path, config), std::runtime_error);
+
+  // converted model is cached and reloaded from there
+  config.backend = tensorflow_cpp::Backend::kTensorRT;
+  config.precision = tensorflow_cpp::Precision::kDefault;
+  config.engine_cache_dir = testing::TempDir();
+  if (!tensorflow_cpp::isTensorRTAvailable() || model.isFrozenGraph()) {
+    EXPECT_THROW(tensorflow_cpp::Model(model_path, config), std::runtime_error);
+    return;
+  }
+  for (int k = 0; k < 2; k++) {
+    tensorflow_cpp::Model trt_model(model_path, config);
+    ASSERT_TRUE(trt_model.isLoaded());
+    EXPECT_EQ(trt_model.inputNames(), model.inputNames());
+    EXPECT_EQ(trt_model(model.makeDummyInputs()).size(), model.nOutputs());
+  }
+}
+
+
+TEST(tensorflow_cpp, loadModelWithWarmupProfile) {
+
+  tensorflow_cpp::WarmupProfile profile;
+  profile.batch_sizes = {1, 4};
+  profile.n_runs = 2;
+  profile.n_threads = 2;
+  tensorflow_cpp::Model model(model_path, tensorflow_cpp::SessionConfig(),
+                              profile);
+
+  EXPECT_TRUE(model.isLoaded());
+
+  profile.batch_sizes = {};
+  profile.inputs = {model.makeDummyInputs(2)};
+  EXPECT_NO_THROW(model.warmup(profile));
+
+  // a model whose warmup fails is not loaded
+  profile.input_shapes = {std::vector<std::vector<int>>(model.nInputs() + 1)};
+  EXPECT_THROW(
+    model.loadModel(model_path, tensorflow_cpp::SessionConfig(), profile),
+    std::runtime_error);
+  EXPECT_FALSE(model.isLoaded());
+}
+
+
+TEST(tensorflow_cpp, loadModelWithoutGraphDef) {
+
+  tensorflow_cpp::Model full_model(model_path);
+  tensorflow_cpp::SessionConfig config;
+  config.keep_graph_def = false;
+  tensorflow_cpp::Model model(model_path, config, true);
+
+  EXPECT_TRUE(model.isLoaded());
+  EXPECT_EQ(model.inputNames(), full_model.inputNames());
+  EXPECT_EQ(model.outputNames(), full_model.outputNames());
+  if (model.isFrozenGraph()) {
+    EXPECT_EQ(model.frozenGraph().node_size(),
+              model.nInputs() + model.nOutputs());
+    EXPECT_EQ(model.getInfoString(), full_model.getInfoString());
+  }
+}
+
+
+TEST(tensorflow_cpp, loadModelGraphIndex) {
+
+  EXPECT_EQ(tensorflow_cpp::GraphIndex::inputNodeName("node"), "node");
+  EXPECT_EQ(tensorflow_cpp::GraphIndex::inputNodeName("node:1"), "node");
+  EXPECT_EQ(tensorflow_cpp::GraphIndex::inputNodeName("^node"), "node");
+
+  tensorflow_cpp::Model model(model_path);
+  if (!model.isFrozenGraph()) return;
+  const tensorflow::GraphDef& graph_def = model.frozenGraph();
+  tensorflow_cpp::GraphIndex index(graph_def);
+
+  EXPECT_EQ(index.size(), graph_def.node_size());
+  EXPECT_EQ(index.inputNames(), tensorflow_cpp::getGraphInputNames(graph_def));
+  EXPECT_EQ(index.outputNames(), model.outputNames());
+  for (const auto& node : graph_def.node()) {
+    EXPECT_EQ(index.nodeShape(node.name()),
+              tensorflow_cpp::getGraphNodeShape(graph_def, node.name()));
+    EXPECT_EQ(index.nodeType(node.name()),
+              tensorflow_cpp::getGraphNodeType(graph_def, node.name()));
+  }
+  for (const auto& name : model.inputNames())
+    EXPECT_FALSE(index.consumers(name).empty());
+  for (const auto& name : model.outputNames())
+    EXPECT_TRUE(index.consumers(name).empty());
+  EXPECT_FALSE(index.contains("__missing__"));
+}
+
+
+TEST(tensorflow_cpp, loadModelOptimized) {
+
+  tensorflow_cpp::Model full_model(model_path);
+  if (!full_model.isFrozenGraph()) return;
+  tensorflow_cpp::SessionConfig config;
+  config.optimize_graph = true;
+  config.optimized_graph_cache_dir =
+    testing::TempDir() + "/tensorflow_cpp_graph_cache";
+
+  // second load is served from the cache
+  const std::vector<tensorflow::Tensor> inputs = full_model.makeDummyInputs();
+  const std::vector<tensorflow::Tensor> expected = full_model(inputs);
+  for (int k = 0; k < 2; k++) {
+    tensorflow_cpp::Model model(model_path, config);
+    ASSERT_TRUE(model.isLoaded());
+    EXPECT_EQ(model.inputNames(), full_model.inputNames());
+    EXPECT_EQ(model.outputNames(), full_model.outputNames());
+    EXPECT_LE(model.frozenGraph().node_size(),
+              full_model.frozenGraph().node_size());
+    const std::vector<tensorflow::Tensor> outputs = model(inputs);
+    ASSERT_EQ(outputs.size(), expected.size());
+    for (int i = 0; i < outputs.size(); i++) {
+      auto output = outputs[i].flat<float>();
+      auto expected_output = expected[i].flat<float>();
+      ASSERT_EQ(output.size(), expected_output.size());
+      for (int j = 0; j < output.size(); j++)
+        EXPECT_NEAR(output(j), expected_output(j), 1e-5);
+    }
+  }
+}
+
+
+TEST(tensorflow_cpp, loadModelMemoryStats) {
+
+  tensorflow_cpp::Model model(model_path);
+  model(model.makeDummyInputs());
+
+  for (const std::string device : {"", "/device:CPU:0"}) {
+    const tensorflow_cpp::MemoryStats stats = model.memoryStats(device);
+    if (!stats.is_available) continue;
+    EXPECT_LE(stats.bytes_in_use, stats.peak_bytes_in_use);
+    EXPECT_GE(stats.fragmentation(), 0.0);
+    EXPECT_LE(stats.fragmentation(), 1.0);
+  }
+}
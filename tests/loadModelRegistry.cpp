@@ -0,0 +1,56 @@
+#include <exception>
+#include <future>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/model_registry.h>
+
+
+std::string model_path;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  return RUN_ALL_TESTS();
+}
+
+
+TEST(tensorflow_cpp, loadAsync) {
+
+  tensorflow_cpp::Model model;
+  std::future<void> loading = model.loadAsync(model_path);
+  loading.get();
+  EXPECT_TRUE(model.isLoaded());
+
+  tensorflow_cpp::Model model_callback;
+  std::promise<std::exception_ptr> callback_promise;
+  model_callback.loadAsync(
+    model_path, tensorflow_cpp::SessionConfig(), true,
+    [&](std::exception_ptr error) { callback_promise.set_value(error); });
+  EXPECT_FALSE(callback_promise.get_future().get());
+  EXPECT_TRUE(model_callback.isLoaded());
+}
+
+
+TEST(tensorflow_cpp, loadModelRegistry) {
+
+  tensorflow_cpp::ModelRegistry registry(2);
+  registry.add("eager_1", model_path);
+  registry.add("eager_2", model_path, tensorflow_cpp::SessionConfig(), true);
+  registry.add("lazy", model_path, tensorflow_cpp::SessionConfig(), false,
+               true);
+  EXPECT_THROW(registry.add("lazy", model_path), std::runtime_error);
+
+  registry.wait();
+  EXPECT_TRUE(registry.isLoaded("eager_1"));
+  EXPECT_TRUE(registry.isLoaded("eager_2"));
+  EXPECT_FALSE(registry.isLoaded("lazy"));
+
+  EXPECT_TRUE(registry.get("lazy").isLoaded());
+  EXPECT_TRUE(registry.isLoaded("lazy"));
+  EXPECT_EQ(registry.names().size(), 3);
+  EXPECT_THROW(registry.get("unknown"), std::runtime_error);
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/preprocessing.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadImage() {
+
+  // define graph for decoding input image to uint8 (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+
+  // execute graph to load image tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({decode_jpeg_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+TEST(tensorflow_cpp, preprocessImage) {
+
+  // 1x2 BGR image
+  const std::vector<uint8_t> image = {10, 20, 30, 40, 50, 60};
+  tensorflow_cpp::PreprocessingConfig config;
+  config.scale = 0.5f;
+  config.mean = {1, 2, 3};
+  config.stddev = {1, 2, 4};
+  config.channel_order = {2, 1, 0};
+
+  std::vector<float> hwc(6);
+  tensorflow_cpp::preprocessImage(image.data(), 1, 2, 3, 0, config,
+                                  hwc.data());
+  EXPECT_EQ(hwc, std::vector<float>({14, 4, 0.5, 29, 11.5, 4.25}));
+
+  config.channels_first = true;
+  std::vector<float> chw(6);
+  tensorflow_cpp::preprocessImage(image.data(), 1, 2, 3, 0, config,
+                                  chw.data());
+  EXPECT_EQ(chw, std::vector<float>({14, 29, 4, 11.5, 0.5, 4.25}));
+
+  config.mean = {1, 2};
+  EXPECT_THROW(tensorflow_cpp::preprocessImage(image.data(), 1, 2, 3, 0,
+                                               config, chw.data()),
+               std::runtime_error);
+}
+
+
+TEST(tensorflow_cpp, preprocessModelInput) {
+
+  tensorflow::Tensor image = loadImage();
+  const int height = image.dim_size(0);
+  const int width = image.dim_size(1);
+  const int channels = image.dim_size(2);
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  EXPECT_THROW(model.preprocess(image.flat<uint8_t>().data(), height, width,
+                                channels),
+               std::runtime_error);
+
+  tensorflow_cpp::PreprocessingConfig config;
+  config.scale = 1.0f / 255.0f;
+  model.setPreprocessing(config);
+  tensorflow::Tensor input_tensor = model.preprocess(
+    image.flat<uint8_t>().data(), height, width, channels);
+
+  tensorflow::Tensor out = model(input_tensor);
+  auto probabilities = out.flat<float>();
+  int predicted_digit =
+    std::max_element(probabilities.data(),
+                     probabilities.data() + probabilities.size()) -
+    probabilities.data();
+  EXPECT_EQ(predicted_digit, actual_digit);
+}
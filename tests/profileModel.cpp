@@ -0,0 +1,137 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow_cpp/metrics_exporter.h>
+#include <tensorflow_cpp/model.h>
+
+
+std::string model_path;
+
+
+class CountingObserver : public tensorflow_cpp::ModelObserver {
+
+ public:
+  void preRun(const tensorflow_cpp::RunEvent& event) override {
+    n_pre_runs++;
+    batch_size = event.batch_size;
+    n_inputs = event.input_shapes.size();
+  }
+
+  void postRun(const tensorflow_cpp::RunEvent& event) override {
+    n_post_runs++;
+    if (event.ok) duration_ms = event.duration_ms;
+  }
+
+  int n_pre_runs = 0;
+  int n_post_runs = 0;
+  long batch_size = 0;
+  int n_inputs = 0;
+  double duration_ms = 0;
+};
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  return RUN_ALL_TESTS();
+}
+
+
+TEST(tensorflow_cpp, profileModel) {
+
+  tensorflow_cpp::Model model(model_path);
+  std::vector<tensorflow::Tensor> inputs = model.makeDummyInputs();
+  std::vector<tensorflow::Tensor> outputs;
+
+  // calls are not recorded unless profiling is enabled
+  model.run(inputs, outputs);
+  EXPECT_FALSE(model.isProfiling());
+  EXPECT_EQ(model.profilingStats().n_calls, 0);
+
+  // record calls, tracing every second call
+  model.enableProfiling(2);
+  for (int k = 0; k < 4; k++) model.run(inputs, outputs);
+  model(inputs);
+  tensorflow_cpp::ProfilingStats stats = model.profilingStats();
+  EXPECT_EQ(stats.n_calls, 5);
+  EXPECT_EQ(stats.n_traced_calls, 3);
+  EXPECT_GT(stats.total_ms, 0);
+  EXPECT_GE(stats.total_ms, stats.session_ms);
+  EXPECT_GE(stats.max_ms, stats.meanMs());
+  long n_histogram_calls = 0;
+  for (const long count : stats.histogram_counts) n_histogram_calls += count;
+  EXPECT_EQ(n_histogram_calls, stats.n_calls);
+
+  // traced calls provide step stats
+  EXPECT_GT(stats.last_run_metadata.step_stats().dev_stats_size(), 0);
+  EXPECT_NE(model.getChromeTrace().find("traceEvents"), std::string::npos);
+
+  // device callables cannot be traced, they keep the last trace
+  const std::string trace = model.getChromeTrace();
+  tensorflow_cpp::Callable device_callable =
+    model.makeCallable(model.inputNames(), model.outputNames(), "",
+                       "/job:localhost/replica:0/task:0/device:CPU:0");
+  for (int k = 0; k < 2; k++) model.run(device_callable, inputs, outputs);
+  stats = model.profilingStats();
+  EXPECT_EQ(stats.n_calls, 7);
+  EXPECT_EQ(stats.n_traced_calls, 3);
+  EXPECT_EQ(model.getChromeTrace(), trace);
+  model.releaseCallable(device_callable);
+
+  model.resetProfilingStats();
+  EXPECT_EQ(model.profilingStats().n_calls, 0);
+  model.disableProfiling();
+  EXPECT_FALSE(model.isProfiling());
+}
+
+
+TEST(tensorflow_cpp, observeModel) {
+
+  tensorflow_cpp::Model model(model_path);
+  std::vector<tensorflow::Tensor> inputs = model.makeDummyInputs(2);
+  std::vector<tensorflow::Tensor> outputs;
+  EXPECT_EQ(model.name(), model_path);
+  EXPECT_EQ(model.observer(), nullptr);
+
+  // observers are notified around every session run
+  auto observer = std::make_shared<CountingObserver>();
+  model.setObserver(observer);
+  model.run(inputs, outputs);
+  model(inputs);
+  EXPECT_EQ(observer->n_pre_runs, 2);
+  EXPECT_EQ(observer->n_post_runs, 2);
+  EXPECT_EQ(observer->batch_size, 2);
+  EXPECT_EQ(observer->n_inputs, model.nInputs());
+  EXPECT_GT(observer->duration_ms, 0);
+
+  // the exporter reports metrics per model name
+  auto exporter = std::make_shared<tensorflow_cpp::MetricsExporter>();
+  model.setObserver(exporter);
+  model.setName("mnist");
+  for (int k = 0; k < 3; k++) model.run(inputs, outputs);
+  exporter->watchQueue("mnist", [&model]() { return model.asyncQueueSize(); });
+  exporter->watchMemory(model);
+  const std::string text = exporter->exportText();
+  EXPECT_NE(text.find("tensorflow_cpp_runs_total{model=\"mnist\"} 3"),
+            std::string::npos);
+  EXPECT_NE(text.find("tensorflow_cpp_samples_total{model=\"mnist\"} 6"),
+            std::string::npos);
+  EXPECT_NE(
+    text.find("tensorflow_cpp_latency_ms_bucket{model=\"mnist\",le=\"+Inf\"} 3"),
+    std::string::npos);
+  EXPECT_NE(text.find("tensorflow_cpp_queue_size{model=\"mnist\"} 0"),
+            std::string::npos);
+  EXPECT_NE(text.find("tensorflow_cpp_memory_bytes_in_use{model=\"mnist\"}"),
+            std::string::npos);
+  EXPECT_GE(exporter->qps("mnist"), 0);
+  EXPECT_EQ(exporter->qps("does_not_exist"), 0);
+
+  model.setObserver(nullptr);
+  model.run(inputs, outputs);
+  EXPECT_NE(
+    exporter->exportText().find("tensorflow_cpp_runs_total{model=\"mnist\"} 3"),
+    std::string::npos);
+}
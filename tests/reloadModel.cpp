@@ -0,0 +1,84 @@
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/reloadable_model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+TEST(tensorflow_cpp, reloadModel) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::ReloadableModel model(model_path);
+  ASSERT_TRUE(model.isLoaded());
+  EXPECT_EQ(model.version(), 1);
+  tensorflow::Tensor expected = model(input_tensor);
+  std::shared_ptr<const tensorflow_cpp::Model> snapshot = model.model();
+
+  // keep running while reloading in the background
+  std::atomic<bool> done(false);
+  std::atomic<int> n_mismatches(0);
+  std::thread caller([&]() {
+    while (!done) {
+      tensorflow::Tensor out = model(input_tensor);
+      for (int i = 0; i < expected.NumElements(); i++)
+        if (std::abs(out.flat<float>()(i) - expected.flat<float>()(i)) > 1e-5)
+          n_mismatches++;
+    }
+  });
+  model.reload(model_path).get();
+  done = true;
+  caller.join();
+  EXPECT_EQ(n_mismatches, 0);
+  EXPECT_EQ(model.version(), 2);
+  EXPECT_NE(model.model(), snapshot);
+
+  // previous snapshot stays usable
+  tensorflow::Tensor snapshot_out = (*snapshot)(input_tensor);
+  EXPECT_FLOAT_EQ(snapshot_out.flat<float>()(0), expected.flat<float>()(0));
+
+  // failed reload keeps current model
+  EXPECT_ANY_THROW(model.reload(model_path + "_does_not_exist").get());
+  EXPECT_EQ(model.version(), 2);
+  EXPECT_TRUE(model.isLoaded());
+}
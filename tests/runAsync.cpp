@@ -0,0 +1,80 @@
+#include <future>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+TEST(tensorflow_cpp, runAsync) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // queue multiple asynchronous runs
+  std::vector<std::future<std::vector<tensorflow::Tensor>>> futures;
+  for (int k = 0; k < 4; k++) futures.push_back(model.runAsync({input_tensor}));
+
+  // run with completion callback
+  std::promise<std::vector<tensorflow::Tensor>> callback_promise;
+  model.runAsync({input_tensor}, [&](std::vector<tensorflow::Tensor>&& outputs,
+                                     std::exception_ptr error) {
+    if (error)
+      callback_promise.set_exception(error);
+    else
+      callback_promise.set_value(std::move(outputs));
+  });
+  futures.push_back(callback_promise.get_future());
+
+  // results must match synchronous run
+  for (auto& future : futures) {
+    auto outputs = future.get();
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_EQ(outputs[0].NumElements(), expected.NumElements());
+    for (int i = 0; i < outputs[0].NumElements(); i++)
+      EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+  }
+
+  // errors are passed on through the future
+  auto failing = model.runAsync(std::vector<tensorflow::Tensor>{});
+  EXPECT_THROW(failing.get(), std::runtime_error);
+}
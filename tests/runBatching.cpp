@@ -0,0 +1,110 @@
+#include <future>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow/core/framework/tensor_util.h>
+#include <tensorflow_cpp/batching_model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+TEST(tensorflow_cpp, runBatching) {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+  tensorflow::Tensor input_tensor;
+  ASSERT_TRUE(input_tensor.CopyFrom(outputs[0], tensorflow::TensorShape({1, 28, 28})));
+
+  // load model with batching front-end (tensorflow_cpp)
+  const int n_requests = 16;
+  tensorflow_cpp::BatchingModel model(model_path, 8, 10000);
+  ASSERT_TRUE(model.isLoaded());
+
+  // queue requests, which are expected to be batched
+  std::vector<std::future<std::vector<tensorflow::Tensor>>> futures;
+  for (int r = 0; r < n_requests; r++) futures.push_back(model.enqueue({input_tensor}));
+
+  // test predictions of each request
+  for (auto& future : futures) {
+    auto out = future.get();
+    ASSERT_EQ(out.size(), 1);
+    ASSERT_EQ(out[0].dim_size(0), 1);
+    int predicted_digit = 0;
+    float max_probability = 0.0;
+    for (int i = 0; i < out[0].shape().dim_size(1); i++) {
+      float probability = out[0].tensor<float, 2>()(0, i);
+      if (probability > max_probability) {
+        max_probability = probability;
+        predicted_digit = i;
+      }
+    }
+    EXPECT_EQ(predicted_digit, actual_digit);
+  }
+  EXPECT_EQ(model.queueSize(), 0);
+}
+
+
+TEST(tensorflow_cpp, runMicroBatched) {
+
+  // define and execute graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+  tensorflow::Tensor input_tensor;
+  ASSERT_TRUE(input_tensor.CopyFrom(outputs[0], tensorflow::TensorShape({1, 28, 28})));
+
+  // build oversized batch
+  const int batch_size = 10;
+  tensorflow::Tensor batch;
+  std::vector<tensorflow::Tensor> samples(batch_size, input_tensor);
+  ASSERT_TRUE(tensorflow::tensor::Concat(samples, &batch).ok());
+
+  tensorflow_cpp::Model model(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // run serially and in parallel, with a partial last micro-batch
+  for (const int n_parallel : {1, 3}) {
+    model.setMicroBatching(3, n_parallel);
+    EXPECT_EQ(model.microBatchSize(), 3);
+    tensorflow::Tensor out = model(batch);
+    ASSERT_EQ(out.dim_size(0), batch_size);
+    auto out_matrix = out.tensor<float, 2>();
+    auto expected_matrix = expected.tensor<float, 2>();
+    for (int b = 0; b < batch_size; b++) {
+      for (int i = 0; i < expected.dim_size(1); i++)
+        EXPECT_FLOAT_EQ(out_matrix(b, i), expected_matrix(0, i));
+    }
+  }
+}
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+TEST(tensorflow_cpp, runCallable) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  // load model and precompile callable (tensorflow_cpp)
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  EXPECT_TRUE(model.defaultCallable().is_valid);
+  tensorflow_cpp::Callable callable =
+    model.makeCallable(model.inputNames(), model.outputNames());
+  ASSERT_TRUE(callable.is_valid);
+
+  // run callable repeatedly, results must match regular run
+  tensorflow::Tensor expected = model(input_tensor);
+  for (int k = 0; k < 3; k++) {
+    auto out = model(callable, {input_tensor});
+    ASSERT_EQ(out.size(), 1);
+    ASSERT_EQ(out[0].NumElements(), expected.NumElements());
+    for (int i = 0; i < out[0].NumElements(); i++)
+      EXPECT_FLOAT_EQ(out[0].flat<float>()(i), expected.flat<float>()(i));
+  }
+
+  // find most likely prediction
+  auto out = model(callable, {input_tensor})[0];
+  int predicted_digit = 0;
+  float max_probability = 0.0;
+  for (int i = 0; i < out.shape().dim_size(1); i++) {
+    float probability = out.tensor<float, 2>()(0, i);
+    if (probability > max_probability) {
+      max_probability = probability;
+      predicted_digit = i;
+    }
+  }
+  EXPECT_EQ(predicted_digit, actual_digit);
+
+  model.releaseCallable(callable);
+  EXPECT_FALSE(callable.is_valid);
+}
+
+
+TEST(tensorflow_cpp, runIntoOutputs) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // reuse the same input/output vectors across calls
+  std::vector<tensorflow::Tensor> inputs = {input_tensor};
+  std::vector<tensorflow::Tensor> outputs;
+  for (int k = 0; k < 3; k++) {
+    model.run(inputs, outputs);
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_EQ(outputs[0].NumElements(), expected.NumElements());
+    for (int i = 0; i < outputs[0].NumElements(); i++)
+      EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+  }
+}
+
+
+TEST(tensorflow_cpp, runByIndex) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // resolve input/output names once
+  const int input_idx = model.inputIndex(model.inputNames()[0]);
+  const int output_idx = model.outputIndex(model.outputNames()[0]);
+  EXPECT_EQ(input_idx, 0);
+  EXPECT_EQ(output_idx, 0);
+  EXPECT_THROW(model.inputIndex("does_not_exist"), std::runtime_error);
+
+  // run by index, with and without callable
+  auto outputs = model({{input_idx, input_tensor}}, {output_idx});
+  tensorflow_cpp::Callable callable =
+    model.makeCallable(std::vector<int>{input_idx}, std::vector<int>{output_idx});
+  auto callable_outputs = model(callable, {input_tensor});
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(callable_outputs.size(), 1);
+  for (int i = 0; i < expected.NumElements(); i++) {
+    EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+    EXPECT_FLOAT_EQ(callable_outputs[0].flat<float>()(i),
+                    expected.flat<float>()(i));
+  }
+}
+
+
+TEST(tensorflow_cpp, runMovedInputs) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // inputs passed as rvalues are moved into the session feeds
+  std::vector<tensorflow::Tensor> input_tensors = {input_tensor};
+  auto outputs = model(std::move(input_tensors));
+  auto named_outputs =
+    model({{model.inputNames()[0], input_tensor}}, model.outputNames());
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(named_outputs.size(), 1);
+  const tensorflow::Tensor& named_output =
+    named_outputs.at(model.outputNames()[0]);
+  for (int i = 0; i < expected.NumElements(); i++) {
+    EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+    EXPECT_FLOAT_EQ(named_output.flat<float>()(i), expected.flat<float>()(i));
+  }
+  EXPECT_THROW(model(std::vector<tensorflow::Tensor>{}), std::runtime_error);
+}
+
+
+TEST(tensorflow_cpp, runValidatedInputs) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  // input specs are precompiled from the input shapes/types
+  tensorflow_cpp::Model model;
+  tensorflow_cpp::SessionConfig config;
+  config.input_validation = tensorflow_cpp::InputValidation::kCheck;
+  model.loadModel(model_path, config);
+  ASSERT_EQ(model.inputSpecs().size(), 1);
+  EXPECT_EQ(model.inputSpecs()[0].shape, model.getInputShapes()[0]);
+  EXPECT_EQ(model.inputSpecs()[0].dtype, model.getInputTypes()[0]);
+
+  // only leading dimensions of size 1 are added or dropped on conversion
+  const auto& spec = model.inputSpecs()[0];
+  tensorflow::Tensor image, batched_image;
+  ASSERT_TRUE(image.CopyFrom(
+    input_tensor, {input_tensor.dim_size(0), input_tensor.dim_size(1)}));
+  ASSERT_TRUE(batched_image.CopyFrom(
+    input_tensor, {1, 1, input_tensor.dim_size(0), input_tensor.dim_size(1)}));
+  tensorflow::Tensor converted = tensorflow_cpp::convertInput(spec, image);
+  EXPECT_TRUE(tensorflow_cpp::matchesInputSpec(spec, converted));
+  EXPECT_TRUE(tensorflow_cpp::matchesInputSpec(
+    spec, tensorflow_cpp::convertInput(spec, batched_image)));
+  EXPECT_THROW(tensorflow_cpp::convertInput(spec, input_tensor),
+               std::runtime_error);
+
+  // mismatching inputs are rejected before running the session
+  tensorflow::Tensor cast =
+    tensorflow_cpp::castTensor(converted, tensorflow::DT_DOUBLE);
+  EXPECT_THROW(model(cast), std::runtime_error);
+  EXPECT_THROW(model(std::vector<tensorflow::Tensor>{cast}),
+               std::runtime_error);
+  EXPECT_THROW(model(model.makeCallable(model.inputNames(),
+                                        model.outputNames()),
+                     {cast}),
+               std::runtime_error);
+  EXPECT_THROW(model("serving_default", {cast}), std::runtime_error);
+  tensorflow::Tensor output = model(converted);
+
+  // mismatching inputs are cast and reshaped instead
+  config.input_validation = tensorflow_cpp::InputValidation::kConvert;
+  model.loadModel(model_path, config);
+  tensorflow::Tensor cast_output =
+    model(tensorflow_cpp::castTensor(image, tensorflow::DT_DOUBLE));
+  EXPECT_THROW(model(input_tensor), std::runtime_error);
+  tensorflow::Tensor callable_output = model(
+    model.makeCallable(model.inputNames(), model.outputNames()), {image})[0];
+  ASSERT_EQ(cast_output.NumElements(), output.NumElements());
+  ASSERT_EQ(callable_output.NumElements(), output.NumElements());
+  for (int i = 0; i < output.NumElements(); i++) {
+    EXPECT_FLOAT_EQ(cast_output.flat<float>()(i), output.flat<float>()(i));
+    EXPECT_FLOAT_EQ(callable_output.flat<float>()(i), output.flat<float>()(i));
+  }
+}
+
+
+TEST(tensorflow_cpp, runSignature) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // all signatures are resolved on load, the default one matches the model
+  const auto names = model.signatureNames();
+  ASSERT_NE(std::find(names.begin(), names.end(), "serving_default"),
+            names.end());
+  const tensorflow_cpp::Signature& signature =
+    model.signature("serving_default");
+  EXPECT_EQ(signature.input_names, model.inputNames());
+  EXPECT_EQ(signature.output_names, model.outputNames());
+  EXPECT_TRUE(signature.callable.is_valid);
+  EXPECT_THROW(model.signature("does_not_exist"), std::runtime_error);
+
+  // run signature by handle, by name and by layer names
+  auto outputs = model(signature, {input_tensor});
+  auto named_outputs = model("serving_default", {input_tensor});
+  auto layer_outputs =
+    model("serving_default", {{signature.input_names[0], input_tensor}},
+          {signature.output_names[0]});
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(named_outputs.size(), 1);
+  const tensorflow::Tensor& layer_output =
+    layer_outputs[signature.output_names[0]];
+  for (int i = 0; i < expected.NumElements(); i++) {
+    EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+    EXPECT_FLOAT_EQ(named_outputs[0].flat<float>()(i),
+                    expected.flat<float>()(i));
+    EXPECT_FLOAT_EQ(layer_output.flat<float>()(i), expected.flat<float>()(i));
+  }
+}
@@ -0,0 +1,77 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/concurrent_model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+TEST(tensorflow_cpp, runConcurrent) {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+  tensorflow::Tensor input_tensor = outputs[0];
+
+  // load model shared by all threads (tensorflow_cpp)
+  const int n_threads = 4;
+  const int n_runs = 20;
+  tensorflow_cpp::ConcurrentModel model(model_path, n_threads);
+  ASSERT_TRUE(model.isLoaded());
+  EXPECT_EQ(model.nWorkers(), n_threads);
+
+  // run model concurrently and record predictions
+  std::vector<int> predicted_digits(n_threads * n_runs, -1);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<tensorflow::Tensor> inputs = {input_tensor};
+      std::vector<tensorflow::Tensor> outputs;
+      for (int r = 0; r < n_runs; r++) {
+        model.run(inputs, outputs);
+        const auto& out = outputs[0];
+        int predicted_digit = 0;
+        float max_probability = 0.0;
+        for (int i = 0; i < out.shape().dim_size(1); i++) {
+          float probability = out.tensor<float, 2>()(0, i);
+          if (probability > max_probability) {
+            max_probability = probability;
+            predicted_digit = i;
+          }
+        }
+        predicted_digits[t * n_runs + r] = predicted_digit;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  // test predictions
+  for (const int predicted_digit : predicted_digits)
+    EXPECT_EQ(predicted_digit, actual_digit);
+}
@@ -0,0 +1,163 @@
+#include <future>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow/core/platform/env.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/model_pipeline.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+std::string writeDoublingGraph() {
+
+  // define graph y = x + x
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  auto x_op = tensorflow::ops::Placeholder(
+    scope.WithOpName("x"), tensorflow::DT_FLOAT,
+    tensorflow::ops::Placeholder::Shape({-1, 2}));
+  tensorflow::ops::Add(scope.WithOpName("y"), x_op, x_op);
+
+  // write graph as FrozenGraph
+  tensorflow::GraphDef graph_def;
+  TF_CHECK_OK(scope.ToGraphDef(&graph_def));
+  const std::string path =
+    testing::TempDir() + "/tensorflow_cpp_doubling_graph.pb";
+  TF_CHECK_OK(tensorflow::WriteBinaryProto(tensorflow::Env::Default(), path,
+                                           graph_def));
+
+  return path;
+}
+
+
+TEST(tensorflow_cpp, runPipeline) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // two independent stages run side by side on every frame
+  tensorflow_cpp::ModelPipeline pipeline(2);
+  pipeline.addStage("a", model);
+  pipeline.addStage("b", model);
+  pipeline.start();
+  EXPECT_TRUE(pipeline.isRunning());
+  ASSERT_EQ(pipeline.inputNames().size(), 2);
+  ASSERT_EQ(pipeline.outputNames().size(), 2);
+  EXPECT_EQ(pipeline.inputNames()[0], "a/" + model.inputNames()[0]);
+  EXPECT_EQ(pipeline.outputNames()[1], "b/" + model.outputNames()[0]);
+
+  std::vector<std::future<std::vector<tensorflow::Tensor>>> futures;
+  for (int k = 0; k < 8; k++)
+    futures.push_back(pipeline.enqueue({input_tensor, input_tensor}));
+  for (auto& future : futures) {
+    auto outputs = future.get();
+    ASSERT_EQ(outputs.size(), 2);
+    for (const auto& output : outputs)
+      for (int i = 0; i < expected.NumElements(); i++)
+        EXPECT_FLOAT_EQ(output.flat<float>()(i), expected.flat<float>()(i));
+  }
+  EXPECT_EQ(pipeline.stageStats("a").n_frames, 8);
+  EXPECT_EQ(pipeline.stageStats("b").n_frames, 8);
+  EXPECT_THROW(pipeline.enqueue({input_tensor}), std::runtime_error);
+  pipeline.stop();
+  EXPECT_FALSE(pipeline.isRunning());
+
+  // edges have to refer to existing stages, outputs and inputs
+  const std::string input = model.inputNames()[0];
+  const std::string output = model.outputNames()[0];
+  EXPECT_THROW(pipeline.connect("a", output, "c", input), std::runtime_error);
+  EXPECT_THROW(pipeline.connect("a", "does_not_exist", "b", input),
+               std::runtime_error);
+  EXPECT_THROW(pipeline.connect("a", output, "a", input), std::runtime_error);
+
+  // an input can only be fed by one edge, and edges must not form cycles
+  pipeline.connect("a", output, "b", input);
+  EXPECT_THROW(pipeline.connect("a", output, "b", input), std::runtime_error);
+  pipeline.connect("b", output, "a", input);
+  EXPECT_THROW(pipeline.start(), std::runtime_error);
+}
+
+
+TEST(tensorflow_cpp, runChainedPipeline) {
+
+  tensorflow_cpp::Model model;
+  model.loadModel(writeDoublingGraph());
+  ASSERT_EQ(model.inputNames(), std::vector<std::string>({"x"}));
+  ASSERT_EQ(model.outputNames(), std::vector<std::string>({"y"}));
+
+  // the output of "a" feeds both "b" and "c", stages are added out of order
+  tensorflow_cpp::ModelPipeline pipeline(2);
+  pipeline.addStage("b", model);
+  pipeline.addStage("a", model);
+  pipeline.addStage("c", model);
+  pipeline.connect("a", "y", "b", "x");
+  pipeline.connect("a", "y", "c", "x");
+  pipeline.start();
+  EXPECT_EQ(pipeline.inputNames(), std::vector<std::string>({"a/x"}));
+  EXPECT_EQ(pipeline.outputNames(),
+            std::vector<std::string>({"b/y", "c/y"}));
+
+  // every frame passes through "a" once and is doubled twice
+  const int n_frames = 6;
+  std::vector<std::future<std::vector<tensorflow::Tensor>>> futures;
+  for (int k = 0; k < n_frames; k++) {
+    tensorflow::Tensor x(tensorflow::DT_FLOAT, {1, 2});
+    x.flat<float>()(0) = k;
+    x.flat<float>()(1) = -k;
+    futures.push_back(pipeline.enqueue({x}));
+  }
+  for (int k = 0; k < n_frames; k++) {
+    auto outputs = futures[k].get();
+    ASSERT_EQ(outputs.size(), 2);
+    for (const auto& output : outputs) {
+      ASSERT_EQ(output.NumElements(), 2);
+      EXPECT_FLOAT_EQ(output.flat<float>()(0), 4.0f * k);
+      EXPECT_FLOAT_EQ(output.flat<float>()(1), -4.0f * k);
+    }
+  }
+  for (const std::string stage : {"a", "b", "c"}) {
+    const tensorflow_cpp::StageStats stats = pipeline.stageStats(stage);
+    EXPECT_EQ(stats.n_frames, n_frames);
+    EXPECT_GE(stats.max_ms, stats.meanMs());
+    EXPECT_EQ(stats.queue_size, 0);
+  }
+  pipeline.stop();
+}
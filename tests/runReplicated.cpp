@@ -0,0 +1,124 @@
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow/core/framework/tensor_util.h>
+#include <tensorflow_cpp/replicated_model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define and execute graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+  tensorflow::Tensor input_tensor;
+  input_tensor.CopyFrom(outputs[0], tensorflow::TensorShape({1, 28, 28}));
+
+  return input_tensor;
+}
+
+
+int predictDigit(const tensorflow::Tensor& out, const int b = 0) {
+
+  auto out_matrix = out.tensor<float, 2>();
+  int predicted_digit = 0;
+  float max_probability = 0.0;
+  for (int i = 0; i < out.dim_size(1); i++) {
+    if (out_matrix(b, i) > max_probability) {
+      max_probability = out_matrix(b, i);
+      predicted_digit = i;
+    }
+  }
+
+  return predicted_digit;
+}
+
+
+TEST(tensorflow_cpp, runReplicated) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  // place two replicas explicitly, CPU keeps the test runnable everywhere
+  const std::vector<std::string> devices = {"/device:CPU:0", "/device:CPU:0"};
+  tensorflow_cpp::ReplicatedModel model(model_path, devices);
+  ASSERT_TRUE(model.isLoaded());
+  ASSERT_EQ(model.nReplicas(), 2);
+  EXPECT_EQ(model.devices(), devices);
+
+  // dispatch concurrent calls with both policies
+  for (const auto policy : {tensorflow_cpp::DispatchPolicy::kRoundRobin,
+                            tensorflow_cpp::DispatchPolicy::kLeastLoaded}) {
+    model.setDispatchPolicy(policy);
+    std::vector<int> predicted_digits(8, -1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < predicted_digits.size(); t++) {
+      threads.emplace_back([&, t]() {
+        predicted_digits[t] = predictDigit(model(input_tensor));
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    for (const int predicted_digit : predicted_digits)
+      EXPECT_EQ(predicted_digit, actual_digit);
+    EXPECT_EQ(model.nInFlight(0), 0);
+    EXPECT_EQ(model.nInFlight(1), 0);
+  }
+}
+
+
+TEST(tensorflow_cpp, runReplicatedSplit) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  // batches that do not divide evenly, so that replicas get differently
+  // sized parts, including more replicas than fit the rounded-up part size
+  const std::vector<std::pair<int, int>> splits = {{2, 5}, {4, 5}, {6, 7},
+                                                   {4, 9}};
+  for (const auto& split : splits) {
+    const int n_replicas = split.first;
+    const int batch_size = split.second;
+    tensorflow::Tensor batch;
+    std::vector<tensorflow::Tensor> samples(batch_size, input_tensor);
+    ASSERT_TRUE(tensorflow::tensor::Concat(samples, &batch).ok());
+
+    tensorflow_cpp::ReplicatedModel model(
+      model_path, std::vector<std::string>(n_replicas, "/device:CPU:0"));
+    model.setBatchSplitting(true);
+    tensorflow::Tensor expected = model.replica(0)(input_tensor);
+    tensorflow::Tensor out = model(batch);
+    ASSERT_EQ(out.dim_size(0), batch_size);
+    auto out_matrix = out.tensor<float, 2>();
+    auto expected_matrix = expected.tensor<float, 2>();
+    for (int b = 0; b < batch_size; b++) {
+      EXPECT_EQ(predictDigit(out, b), actual_digit);
+      for (int i = 0; i < expected.dim_size(1); i++)
+        EXPECT_FLOAT_EQ(out_matrix(b, i), expected_matrix(0, i));
+    }
+    for (int r = 0; r < n_replicas; r++) EXPECT_EQ(model.nInFlight(r), 0);
+  }
+}
@@ -0,0 +1,149 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow/core/platform/env.h>
+#include <tensorflow_cpp/model.h>
+#include <tensorflow_cpp/streaming_session.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+std::string writeStatefulGraph() {
+
+  // define stateful graph, state_out = x + state_in and y = state_in
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  auto x_op = tensorflow::ops::Placeholder(
+    scope.WithOpName("x"), tensorflow::DT_FLOAT,
+    tensorflow::ops::Placeholder::Shape({-1, 2}));
+  auto state_in_op = tensorflow::ops::Placeholder(
+    scope.WithOpName("state_in"), tensorflow::DT_FLOAT,
+    tensorflow::ops::Placeholder::Shape({-1, 2}));
+  tensorflow::ops::Add(scope.WithOpName("state_out"), x_op, state_in_op);
+  tensorflow::ops::Identity(scope.WithOpName("y"), state_in_op);
+
+  // write graph as FrozenGraph
+  tensorflow::GraphDef graph_def;
+  TF_CHECK_OK(scope.ToGraphDef(&graph_def));
+  const std::string path =
+    testing::TempDir() + "/tensorflow_cpp_stateful_graph.pb";
+  TF_CHECK_OK(tensorflow::WriteBinaryProto(tensorflow::Env::Default(), path,
+                                           graph_def));
+
+  return path;
+}
+
+
+TEST(tensorflow_cpp, runStreaming) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+  tensorflow::Tensor expected = model(input_tensor);
+
+  // the model is stateless, so the session reduces to regular steps
+  tensorflow_cpp::StreamingSession stream(model, {});
+  EXPECT_EQ(stream.inputNames(), model.inputNames());
+  EXPECT_EQ(stream.outputNames(), model.outputNames());
+  EXPECT_TRUE(stream.state().empty());
+  EXPECT_FALSE(stream.isStateOnDevice());
+  for (int step = 0; step < 3; step++) {
+    auto outputs = stream({input_tensor});
+    ASSERT_EQ(outputs.size(), 1);
+    for (int i = 0; i < expected.NumElements(); i++)
+      EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), expected.flat<float>()(i));
+  }
+  stream.reset();
+  EXPECT_THROW(stream({}), std::runtime_error);
+
+  // state bindings have to refer to model outputs/inputs
+  EXPECT_THROW(tensorflow_cpp::StreamingSession(
+                 model, {{"does_not_exist", model.inputNames()[0]}}),
+               std::runtime_error);
+  EXPECT_THROW(tensorflow_cpp::StreamingSession(
+                 model, {{model.outputNames()[0], "does_not_exist"}}),
+               std::runtime_error);
+}
+
+
+TEST(tensorflow_cpp, runStreamingState) {
+
+  tensorflow_cpp::Model model;
+  model.loadModel(writeStatefulGraph());
+  tensorflow_cpp::StreamingSession stream(model, {{"state_out", "state_in"}});
+  EXPECT_EQ(stream.inputNames(), std::vector<std::string>({"x"}));
+  EXPECT_EQ(stream.outputNames(), std::vector<std::string>({"y"}));
+  EXPECT_EQ(stream.isStateOnDevice(), !model.gpuDeviceName().empty());
+
+  // state is zero-initialized with the dynamic batch dimension given on reset
+  ASSERT_EQ(stream.state().size(), 1);
+  EXPECT_EQ(stream.state()[0].shape(), tensorflow::TensorShape({1, 2}));
+  stream.reset(3);
+  ASSERT_EQ(stream.state().size(), 1);
+  EXPECT_EQ(stream.state()[0].shape(), tensorflow::TensorShape({3, 2}));
+  for (int i = 0; i < stream.state()[0].NumElements(); i++)
+    EXPECT_FLOAT_EQ(stream.state()[0].flat<float>()(i), 0.0f);
+
+  // state has to match the state bindings
+  tensorflow::Tensor state(tensorflow::DT_FLOAT, {1, 2});
+  state.flat<float>().setConstant(10.0f);
+  EXPECT_THROW(stream.setState({}), std::runtime_error);
+  EXPECT_THROW(stream.setState({state, state}), std::runtime_error);
+
+  // state outputs are fed back, the first step feeds the state from host
+  tensorflow::Tensor x(tensorflow::DT_FLOAT, {1, 2});
+  x.flat<float>()(0) = 1.0f;
+  x.flat<float>()(1) = 2.0f;
+  stream.reset();
+  for (int step = 0; step < 3; step++) {
+    auto outputs = stream({x});
+    ASSERT_EQ(outputs.size(), 1);
+    for (int i = 0; i < x.NumElements(); i++)
+      EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i), step * x.flat<float>()(i));
+  }
+
+  // resuming from a given state feeds it from host again
+  stream.setState({state});
+  for (int step = 0; step < 2; step++) {
+    auto outputs = stream({x});
+    ASSERT_EQ(outputs.size(), 1);
+    for (int i = 0; i < x.NumElements(); i++)
+      EXPECT_FLOAT_EQ(outputs[0].flat<float>()(i),
+                      10.0f + step * x.flat<float>()(i));
+  }
+}
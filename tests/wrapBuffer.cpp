@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tensorflow/cc/client/client_session.h>
+#include <tensorflow/cc/ops/standard_ops.h>
+#include <tensorflow_cpp/model.h>
+
+
+std::string model_path;
+std::string img_path;
+int actual_digit;
+
+
+int main(int argc, char** argv) {
+
+  ::testing::InitGoogleTest(&argc, argv);
+  model_path = argv[1];
+  img_path = argv[2];
+  actual_digit = std::stoi(img_path.substr(img_path.size() - 5, 1));
+  return RUN_ALL_TESTS();
+}
+
+
+tensorflow::Tensor loadInput() {
+
+  // define graph for loading input image (pure TensorFlow C++)
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  tensorflow::ClientSession session(scope);
+  auto read_file_op = tensorflow::ops::ReadFile(scope, img_path);
+  auto decode_jpeg_op = tensorflow::ops::DecodeJpeg(scope, read_file_op);
+  auto cast_op = tensorflow::ops::Cast(scope, decode_jpeg_op, tensorflow::DT_FLOAT);
+  auto const_op = tensorflow::ops::Const(scope, {float(255.0)});
+  auto div_op = tensorflow::ops::Div(scope, cast_op, const_op);
+
+  // execute graph to load input tensor (pure TensorFlow C++)
+  std::vector<tensorflow::Tensor> outputs;
+  session.Run({div_op}, &outputs);
+
+  return outputs[0];
+}
+
+
+TEST(tensorflow_cpp, wrapBuffer) {
+
+  tensorflow::Tensor input_tensor = loadInput();
+
+  tensorflow_cpp::Model model;
+  model.loadModel(model_path);
+
+  // copy input image into an aligned user buffer, e.g. a camera frame
+  const size_t n_bytes = input_tensor.TotalBytes();
+  const size_t n_aligned_bytes = (n_bytes + 63) / 64 * 64;
+  float* buffer = static_cast<float*>(std::aligned_alloc(64, n_aligned_bytes));
+  std::memcpy(buffer, input_tensor.tensor_data().data(), n_bytes);
+
+  // run model on wrapped buffer, buffer is released with the last reference
+  bool released = false;
+  {
+    tensorflow::Tensor wrapped = tensorflow_cpp::wrapBuffer(
+      buffer, input_tensor.shape(), [&]() {
+        std::free(buffer);
+        released = true;
+      });
+    EXPECT_EQ(wrapped.tensor_data().data(),
+              reinterpret_cast<const char*>(buffer));
+
+    tensorflow::Tensor out = model(wrapped);
+    auto probabilities = tensorflow_cpp::tensorSpan<float>(out);
+    int predicted_digit =
+      std::max_element(probabilities.begin(), probabilities.end()) -
+      probabilities.begin();
+    EXPECT_EQ(predicted_digit, actual_digit);
+    EXPECT_THROW(tensorflow_cpp::tensorSpan<int>(out), std::runtime_error);
+  }
+  EXPECT_TRUE(released);
+
+  // unaligned buffers are rejected
+  std::vector<char> unaligned(n_bytes + 1);
+  EXPECT_THROW(tensorflow_cpp::wrapBuffer(
+                 reinterpret_cast<float*>(unaligned.data() + 1),
+                 input_tensor.shape()),
+               std::runtime_error);
+}